@@ -24,8 +24,6 @@ extern int MAX_LOD;
 
 inline lod::KeyboardController::KeyMappings keys;
 
-extern bool DistanceThresholds;
-
 void limitLockedLOD()
 {
 	if (camera.lockedLOD < -1)
@@ -71,9 +69,19 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
 		camera.discrete = !camera.discrete;
 	}
 
+	if (key == keys.frameTime_toggle && action == GLFW_PRESS)
+	{
+		camera.frameTime.enabled = !camera.frameTime.enabled;
+	}
+
+	if (key == keys.pipelinedSelection_toggle && action == GLFW_PRESS)
+	{
+		camera.pipelinedSelection = !camera.pipelinedSelection;
+	}
+
 	if (key == keys.change_threshold && action == GLFW_PRESS)
 	{
-		DistanceThresholds = !DistanceThresholds;
+		camera.distanceThresholds = !camera.distanceThresholds;
 	}
 
 	if (key == keys.autoMove && action == GLFW_PRESS)
@@ -34,6 +34,8 @@ namespace lod
 
             int autoMove = GLFW_KEY_M;
             int discrete_toggle = GLFW_KEY_F;
+            int frameTime_toggle = GLFW_KEY_G;
+            int pipelinedSelection_toggle = GLFW_KEY_N;
 
             // Camera Movement
             int moveLeft = GLFW_KEY_A;
@@ -29,6 +29,11 @@ inline lod::Camera camera;
 inline int NO_TRIANGLES = 0;
 inline int MESHLETS_DRAWN = 0;
 inline int DRAW_CALLS = 0;
+inline int BACKFACE_CULLED = 0;  // Clusters the LoD selection dropped with the normal cone test
+inline int OCCLUSION_CULLED = 0; // Clusters the LoD selection dropped behind the software depth buffer
+inline float RECORD_TIME = 0.0f;         // Milliseconds spent recording the secondary command buffers of the last frame
+inline float SELECTION_TIME = 0.0f;      // Milliseconds the LoD selection drawn in the last frame took
+inline float SELECTION_LATENCY = 0.0f;   // Milliseconds from taking the camera for the selection to drawing it
 
 namespace jsk
 {
@@ -52,6 +57,12 @@ namespace jsk
 		std::vector<int> tri_counts;
 		std::vector<int> meshlet_counts;
 		std::vector<int> drawCall_counts;
+		std::vector<float> lodScales;
+		std::vector<int> backface_counts;
+		std::vector<int> occlusion_counts;
+		std::vector<float> record_times;
+		std::vector<float> selection_times;
+		std::vector<float> selection_latencies;
 		std::string windowTitle = "Jinsoku";
 
 		float timer = 500.0f;
@@ -186,6 +197,7 @@ namespace jsk
 				frameTimer = (float)tDiff / 1000.0f;
 
 				lod::updateCamera(m_pPresenter->getWindow(), tDiff, camera);
+				camera.frameTime.update((float)tDiff);
 
 				frameCounter++;
 
@@ -206,6 +218,15 @@ namespace jsk
 					}
 
 					tempTitle += " - " + std::to_string(DRAW_CALLS) + " Draw Calls";
+					tempTitle += " - " + std::to_string(BACKFACE_CULLED) + " Backface Culled";
+					tempTitle += " - " + std::to_string(OCCLUSION_CULLED) + " Occlusion Culled";
+					tempTitle += " - " + std::to_string(RECORD_TIME) + " ms Recording";
+					tempTitle += " - " + std::to_string(SELECTION_TIME) + " ms Selection (" + std::to_string(SELECTION_LATENCY) + " ms latency)";
+
+					if (camera.frameTime.enabled)
+					{
+						tempTitle += " - LoD scale " + std::to_string(camera.frameTime.scale) + " (target " + std::to_string(camera.frameTime.targetMs) + " ms)";
+					}
 
 					glfwSetWindowTitle(m_pPresenter->getWindow(), tempTitle.c_str());
 					frameCounter = 0;
@@ -216,6 +237,12 @@ namespace jsk
 					tri_counts.push_back(NO_TRIANGLES);
 					meshlet_counts.push_back(MESHLETS_DRAWN);
 					drawCall_counts.push_back(DRAW_CALLS);
+					lodScales.push_back(camera.frameTime.scale);
+					backface_counts.push_back(BACKFACE_CULLED);
+					occlusion_counts.push_back(OCCLUSION_CULLED);
+					record_times.push_back(RECORD_TIME);
+					selection_times.push_back(SELECTION_TIME);
+					selection_latencies.push_back(SELECTION_LATENCY);
 
 					float tolerance = 1.0f;
 					if (glm::length(camera.position - camera.worldCenter) < tolerance)
@@ -236,6 +263,12 @@ namespace jsk
 						<< std::setw(25) << "Triangles: " << std::setw(20) << tri_counts[i]
 						<< std::setw(25) << "Meshlets: " << std::setw(20) << meshlet_counts[i]
 						<< std::setw(25) << "DrawCalls: " << std::setw(20) << tri_counts[i]
+						<< std::setw(25) << "LoDScale: " << std::setw(20) << lodScales[i]
+						<< std::setw(25) << "BackfaceCulled: " << std::setw(20) << backface_counts[i]
+						<< std::setw(25) << "OcclusionCulled: " << std::setw(20) << occlusion_counts[i]
+						<< std::setw(25) << "RecordTime: " << std::setw(20) << record_times[i]
+						<< std::setw(25) << "SelectionTime: " << std::setw(20) << selection_times[i]
+						<< std::setw(25) << "SelectionLatency: " << std::setw(20) << selection_latencies[i]
 						<< "\n";
 				i++;
 			}
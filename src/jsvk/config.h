@@ -41,6 +41,40 @@
 #define NVMESHLET_PRIM_ALIGNMENT 32
 #define NVMESHLET_VERTEX_ALIGNMENT 16
 
+// if set the vertex indices of every meshlet are stored as a 32-bit
+// base followed by 8 or 16-bit deltas (NVMeshlet::VERTEX_DELTA_*),
+// otherwise as plain 32-bit indices
+#ifndef NVMESHLET_VERTEX_DELTA
+#define NVMESHLET_VERTEX_DELTA 0
+#endif
+#define NVMESHLET_VERTEX_DELTA_ALIGNMENT 4
+#define NVMESHLET_VERTEX_DELTA_BASE_BITS 30
+
+// if set the vbo holds one quantized stream instead of float3 positions
+// and float3 normals: positions as UNORM16 relative to the bounds of
+// their LoD mesh, normals octahedral with NORMAL_BITS (8 or 16) per
+// component. The bounds are stored in front of every mesh (HEADER words),
+// STRIDE is the number of 32-bit words per vertex.
+#ifndef NVMESHLET_VERTEX_QUANTIZED
+#define NVMESHLET_VERTEX_QUANTIZED 0
+#endif
+#ifndef NVMESHLET_VERTEX_QUANTIZED_NORMAL_BITS
+#define NVMESHLET_VERTEX_QUANTIZED_NORMAL_BITS 8
+#endif
+#if NVMESHLET_VERTEX_QUANTIZED_NORMAL_BITS == 16
+#define NVMESHLET_VERTEX_QUANTIZED_STRIDE 3
+#else
+#define NVMESHLET_VERTEX_QUANTIZED_STRIDE 2
+#endif
+#define NVMESHLET_VERTEX_QUANTIZED_HEADER 6
+
+// if set the primitive indices of every meshlet are stored as generalized
+// triangle strips (NVMeshlet::unpackPrimitiveStrip) instead of 3 uint8 per
+// triangle, which also allows the full NVMESHLET_PRIMITIVE_COUNT per meshlet
+#ifndef NVMESHLET_PRIMITIVE_STRIPS
+#define NVMESHLET_PRIMITIVE_STRIPS 0
+#endif
+
 #ifdef VULKAN
 #define IS_VULKAN 1
 #endif
@@ -5,9 +5,13 @@
 
 #include <stdexcept>
 #include <iostream>
+#include <climits>
 #include <unordered_map>
 #include <unordered_set>
 #include <queue>
+#include <algorithm>
+#include <numeric>
+#include <limits>
 
 #include <glm/glm.hpp>
 
@@ -959,6 +963,387 @@ namespace mm
 		}
 	}
 
+	// Replaces the plain vertex indices of the geometry with the meshlet-relative
+	// packing (NVMESHLET_VERTEX_DELTA) and rewrites the vertexBegin of every descriptor.
+	// Must run after everything else that reads the vertex indices on the CPU.
+	bool packVertexIndicesDelta(NVMeshlet::Builder<uint32_t>::MeshletGeometry &geometry)
+	{
+		std::vector<uint32_t> packed;
+		std::vector<uint32_t> begins;
+		packed.reserve(geometry.vertexIndices.size() / 2);
+		begins.reserve(geometry.meshletDescriptors.size());
+
+		for (const NVMeshlet::MeshletDesc &meshlet : geometry.meshletDescriptors)
+		{
+			uint32_t vertexCount = meshlet.getNumVertices();
+			uint32_t vertexBegin = meshlet.getVertexBegin();
+
+			uint32_t minIndex = UINT32_MAX;
+			uint32_t maxIndex = 0;
+			for (uint32_t v = 0; v < vertexCount; ++v)
+			{
+				minIndex = std::min(minIndex, geometry.vertexIndices[vertexBegin + v]);
+				maxIndex = std::max(maxIndex, geometry.vertexIndices[vertexBegin + v]);
+			}
+
+			if (minIndex >= (1u << NVMeshlet::VERTEX_DELTA_BASE_BITS))
+			{
+				return false;
+			}
+
+			uint32_t range = maxIndex - minIndex;
+			NVMeshlet::VertexIndexDeltaWidth width = range <= 0xFF ? NVMeshlet::VERTEX_DELTA_UINT8 : range <= 0xFFFF ? NVMeshlet::VERTEX_DELTA_UINT16 : NVMeshlet::VERTEX_DELTA_UINT32;
+
+			uint32_t begin = uint32_t(packed.size());
+			if (!NVMeshlet::MeshletDesc::isVertexBeginDeltaLegal(begin))
+			{
+				return false;
+			}
+
+			packed.resize(begin + NVMeshlet::computeVertexDeltaWords(vertexCount, width), 0);
+			packed[begin] = minIndex | (uint32_t(width) << NVMeshlet::VERTEX_DELTA_BASE_BITS);
+
+			uint32_t *deltas = &packed[begin + 1];
+			for (uint32_t v = 0; v < vertexCount; ++v)
+			{
+				uint32_t delta = geometry.vertexIndices[vertexBegin + v] - minIndex;
+				if (width == NVMeshlet::VERTEX_DELTA_UINT8)
+				{
+					deltas[v / 4] |= delta << ((v % 4) * 8);
+				}
+				else if (width == NVMeshlet::VERTEX_DELTA_UINT16)
+				{
+					deltas[v / 2] |= delta << ((v % 2) * 16);
+				}
+				else
+				{
+					deltas[v] = delta;
+				}
+			}
+
+			while ((packed.size() % NVMeshlet::VERTEX_DELTA_PACKING_ALIGNMENT) != 0)
+			{
+				packed.push_back(0);
+			}
+
+			begins.push_back(begin);
+		}
+
+		// only touch the geometry once everything fit
+		for (size_t i = 0; i < begins.size(); ++i)
+		{
+			geometry.meshletDescriptors[i].setVertexBeginDelta(begins[i]);
+		}
+
+		if (SHOW_MESSAGES)
+		{
+			std::cout << "Vertex indices: " << geometry.vertexIndices.size() * sizeof(uint32_t) << " bytes, delta packed: " << packed.size() * sizeof(uint32_t) << " bytes." << std::endl;
+		}
+
+		geometry.vertexIndices.swap(packed);
+		return true;
+	}
+
+	// Replaces the primitive indices of the geometry with generalized triangle strips (NVMESHLET_PRIMITIVE_STRIPS)
+	// and rewrites the primBegin of every descriptor. Must run after everything else that reads the primitive indices.
+	bool packPrimitiveStrips(NVMeshlet::Builder<uint32_t>::MeshletGeometry &geometry)
+	{
+		std::vector<NVMeshlet::PrimitiveIndexType> packed;
+		std::vector<uint32_t> begins;
+		begins.reserve(geometry.meshletDescriptors.size());
+
+		for (const NVMeshlet::MeshletDesc &meshlet : geometry.meshletDescriptors)
+		{
+			const uint32_t primCount = meshlet.getNumPrims();
+			const uint8_t(*triangles)[3] = reinterpret_cast<const uint8_t(*)[3]>(&geometry.primitiveIndices[meshlet.getPrimBegin()]);
+
+			// triangles per edge of the meshlet
+			std::unordered_map<uint16_t, std::vector<uint32_t>> edgeTriangles;
+			auto edgeKey = [](uint8_t a, uint8_t b)
+			{ return uint16_t((std::min(a, b) << 8) | std::max(a, b)); };
+			for (uint32_t t = 0; t < primCount; t++)
+			{
+				for (int e = 0; e < 3; e++)
+				{
+					edgeTriangles[edgeKey(triangles[t][e], triangles[t][(e + 1) % 3])].push_back(t);
+				}
+			}
+
+			std::vector<bool> visited(primCount, false);
+			auto findNext = [&](uint8_t a, uint8_t b) -> int
+			{
+				for (uint32_t t : edgeTriangles[edgeKey(a, b)])
+				{
+					if (!visited[t])
+					{
+						return int(t);
+					}
+				}
+				return -1;
+			};
+			auto sameWinding = [&](uint8_t a, uint8_t b, uint32_t t)
+			{
+				const uint8_t *tri = triangles[t];
+				return (a == tri[0] && b == tri[1]) || (a == tri[1] && b == tri[2]) || (a == tri[2] && b == tri[0]);
+			};
+
+			const uint32_t maskWords = NVMeshlet::computeStripMaskWords(primCount);
+			std::vector<uint32_t> masks(maskWords * 3, 0);
+			std::vector<uint8_t> entries;
+
+			uint32_t emitted = 0;
+			auto emit = [&](uint32_t restart, uint32_t fan, uint32_t flip)
+			{
+				masks[0 * maskWords + emitted / 32] |= restart << (emitted % 32);
+				masks[1 * maskWords + emitted / 32] |= fan << (emitted % 32);
+				masks[2 * maskWords + emitted / 32] |= flip << (emitted % 32);
+				emitted++;
+			};
+
+			while (emitted < primCount)
+			{
+				// restart at the triangle with the fewest open neighbours
+				uint32_t start = 0;
+				int startOpen = INT_MAX;
+				for (uint32_t t = 0; t < primCount; t++)
+				{
+					if (visited[t])
+					{
+						continue;
+					}
+
+					int open = 0;
+					for (int e = 0; e < 3; e++)
+					{
+						visited[t] = true;
+						open += findNext(triangles[t][e], triangles[t][(e + 1) % 3]) >= 0 ? 1 : 0;
+						visited[t] = false;
+					}
+					if (open < startOpen)
+					{
+						start = t;
+						startOpen = open;
+					}
+				}
+				visited[start] = true;
+
+				// rotate so the strip can continue over the edges of the newest vertex
+				int rotation = 0;
+				for (int r = 0; r < 3; r++)
+				{
+					uint8_t a = triangles[start][r];
+					uint8_t b = triangles[start][(r + 1) % 3];
+					uint8_t c = triangles[start][(r + 2) % 3];
+					if (findNext(b, c) >= 0 || findNext(a, c) >= 0)
+					{
+						rotation = r;
+						break;
+					}
+				}
+
+				uint8_t other = triangles[start][rotation];
+				uint8_t previous = triangles[start][(rotation + 1) % 3];
+				uint8_t last = triangles[start][(rotation + 2) % 3];
+				entries.push_back(other);
+				entries.push_back(previous);
+				entries.push_back(last);
+				emit(1, 0, 0);
+
+				while (true)
+				{
+					int next = findNext(previous, last);
+					bool fan = next < 0;
+					if (fan)
+					{
+						next = findNext(other, last);
+					}
+					if (next < 0)
+					{
+						break;
+					}
+					visited[next] = true;
+
+					if (!fan)
+					{
+						other = previous;
+					}
+
+					uint8_t newest = 0;
+					for (int e = 0; e < 3; e++)
+					{
+						if (triangles[next][e] != other && triangles[next][e] != last)
+						{
+							newest = triangles[next][e];
+						}
+					}
+
+					entries.push_back(newest);
+					emit(0, fan ? 1 : 0, sameWinding(other, last, next) ? 0 : 1);
+
+					previous = last;
+					last = newest;
+				}
+			}
+
+			uint32_t begin = uint32_t(packed.size());
+			if (!NVMeshlet::MeshletDesc::isPrimBeginLegal(begin))
+			{
+				return false;
+			}
+			begins.push_back(begin);
+
+			packed.resize(begin + NVMeshlet::computeStripSize(primCount, uint32_t(entries.size())));
+			memcpy(&packed[begin], masks.data(), masks.size() * sizeof(uint32_t));
+			memcpy(&packed[begin + masks.size() * sizeof(uint32_t)], entries.data(), entries.size());
+
+			while ((packed.size() % NVMeshlet::PRIMITIVE_PACKING_ALIGNMENT) != 0)
+			{
+				packed.push_back(0);
+			}
+
+			// the decoder must give back the same triangles with the same winding
+			uint8_t decoded[NVMeshlet::MAX_PRIMITIVE_COUNT_LIMIT][3];
+			NVMeshlet::unpackPrimitiveStrip(&packed[begin], primCount, decoded);
+
+			std::vector<uint32_t> expected;
+			std::vector<uint32_t> actual;
+			auto canonical = [](const uint8_t *tri)
+			{
+				// rotate the smallest index to the front, keeps the winding
+				int r = (tri[0] < tri[1] && tri[0] < tri[2]) ? 0 : (tri[1] < tri[2] ? 1 : 2);
+				return (uint32_t(tri[r]) << 16) | (uint32_t(tri[(r + 1) % 3]) << 8) | uint32_t(tri[(r + 2) % 3]);
+			};
+			for (uint32_t t = 0; t < primCount; t++)
+			{
+				expected.push_back(canonical(triangles[t]));
+				actual.push_back(canonical(decoded[t]));
+			}
+			std::sort(expected.begin(), expected.end());
+			std::sort(actual.begin(), actual.end());
+			if (expected != actual)
+			{
+				return false;
+			}
+		}
+
+		for (size_t i = 0; i < begins.size(); ++i)
+		{
+			geometry.meshletDescriptors[i].resetPrimBegin();
+			geometry.meshletDescriptors[i].setPrimBegin(begins[i]);
+		}
+
+		if (SHOW_MESSAGES)
+		{
+			std::cout << "Primitive indices: " << geometry.primitiveIndices.size() << " bytes, strips: " << packed.size() << " bytes." << std::endl;
+		}
+
+		geometry.primitiveIndices.swap(packed);
+		return true;
+	}
+
+	// Appends one LoD mesh to the quantized vertex stream (NVMESHLET_VERTEX_QUANTIZED).
+	// The bounds of the mesh go first, followed by the vertices, see getPosition/getNormal in meshlet.mesh.
+	void quantizeVertices(const mm::Vertex *vertices, size_t numVertices, std::vector<uint32_t> &stream)
+	{
+		glm::vec3 bboxMin = glm::vec3(numVertices ? FLT_MAX : 0.0f);
+		glm::vec3 bboxMax = glm::vec3(numVertices ? -FLT_MAX : 0.0f);
+		for (size_t i = 0; i < numVertices; ++i)
+		{
+			bboxMin = glm::min(bboxMin, vertices[i].pos);
+			bboxMax = glm::max(bboxMax, vertices[i].pos);
+		}
+		glm::vec3 bboxExtent = bboxMax - bboxMin;
+
+		size_t header = stream.size();
+		stream.resize(header + NVMESHLET_VERTEX_QUANTIZED_HEADER + numVertices * NVMESHLET_VERTEX_QUANTIZED_STRIDE, 0);
+		memcpy(&stream[header + 0], &bboxMin, sizeof(glm::vec3));
+		memcpy(&stream[header + 3], &bboxExtent, sizeof(glm::vec3));
+
+		const float normalMax = float((1 << (NVMESHLET_VERTEX_QUANTIZED_NORMAL_BITS - 1)) - 1);
+		const uint32_t normalMask = (1u << NVMESHLET_VERTEX_QUANTIZED_NORMAL_BITS) - 1;
+
+		for (size_t i = 0; i < numVertices; ++i)
+		{
+			uint32_t q[3];
+			for (int c = 0; c < 3; ++c)
+			{
+				float t = bboxExtent[c] > 0.0f ? (vertices[i].pos[c] - bboxMin[c]) / bboxExtent[c] : 0.0f;
+				q[c] = uint32_t(std::min(std::max(t, 0.0f), 1.0f) * 65535.0f + 0.5f);
+			}
+
+			// the normal is stored in the color
+			NVMeshlet::vec normal = NVMeshlet::vec(vertices[i].color.x, vertices[i].color.y, vertices[i].color.z);
+			normal = NVMeshlet::vec_length(normal) > FLT_EPSILON ? NVMeshlet::vec_normalize(normal) : NVMeshlet::vec(0.0f, 0.0f, 1.0f);
+			NVMeshlet::vec oct = NVMeshlet::float32x3_to_octn_precise(normal, NVMESHLET_VERTEX_QUANTIZED_NORMAL_BITS * 2);
+			uint32_t octX = uint32_t(int32_t(roundf(oct.x * normalMax))) & normalMask;
+			uint32_t octY = uint32_t(int32_t(roundf(oct.y * normalMax))) & normalMask;
+
+			uint32_t *vertex = &stream[header + NVMESHLET_VERTEX_QUANTIZED_HEADER + i * NVMESHLET_VERTEX_QUANTIZED_STRIDE];
+			vertex[0] = q[0] | (q[1] << 16);
+#if NVMESHLET_VERTEX_QUANTIZED_NORMAL_BITS == 16
+			vertex[1] = q[2] | (octX << 16);
+			vertex[2] = octY;
+#else
+			vertex[1] = q[2] | (octX << 16) | (octY << 24);
+#endif
+		}
+	}
+
+	// mirrors getPosition/getNormal in meshlet.mesh, stream points at the bounds of the mesh
+	void dequantizeVertex(const uint32_t *stream, uint32_t vertex, glm::vec3 &pos, glm::vec3 &normal)
+	{
+		glm::vec3 bboxMin;
+		glm::vec3 bboxExtent;
+		memcpy(&bboxMin, &stream[0], sizeof(glm::vec3));
+		memcpy(&bboxExtent, &stream[3], sizeof(glm::vec3));
+
+		const uint32_t *v = &stream[NVMESHLET_VERTEX_QUANTIZED_HEADER + vertex * NVMESHLET_VERTEX_QUANTIZED_STRIDE];
+		glm::vec3 unorm = glm::vec3(float(v[0] & 0xFFFF), float(v[0] >> 16), float(v[1] & 0xFFFF)) / 65535.0f;
+		pos = bboxMin + unorm * bboxExtent;
+
+		const float normalMax = float((1 << (NVMESHLET_VERTEX_QUANTIZED_NORMAL_BITS - 1)) - 1);
+#if NVMESHLET_VERTEX_QUANTIZED_NORMAL_BITS == 16
+		float octX = float(int16_t(v[1] >> 16));
+		float octY = float(int16_t(v[2] & 0xFFFF));
+#else
+		float octX = float(int8_t((v[1] >> 16) & 0xFF));
+		float octY = float(int8_t(v[1] >> 24));
+#endif
+		NVMeshlet::vec n = NVMeshlet::oct_to_float32x3(NVMeshlet::vec(std::max(octX / normalMax, -1.0f), std::max(octY / normalMax, -1.0f), 0.0f));
+		normal = glm::vec3(n.x, n.y, n.z);
+	}
+
+	// Round trip of one mesh of the quantized stream. Positions must come back within half a
+	// quantization step of the mesh bounds, in world units. The normal error is returned in degrees.
+	bool checkQuantizedVertices(const mm::Vertex *vertices, size_t numVertices, const uint32_t *stream, float &maxPositionError, float &maxNormalError)
+	{
+		glm::vec3 bboxExtent;
+		memcpy(&bboxExtent, &stream[3], sizeof(glm::vec3));
+
+		// half a step per axis, plus some slack for the float math
+		float bound = 0.5f * glm::length(bboxExtent) / 65535.0f * 1.001f + FLT_EPSILON * glm::length(bboxExtent);
+
+		maxPositionError = 0.0f;
+		maxNormalError = 0.0f;
+		for (size_t i = 0; i < numVertices; ++i)
+		{
+			glm::vec3 pos;
+			glm::vec3 normal;
+			dequantizeVertex(stream, uint32_t(i), pos, normal);
+
+			maxPositionError = std::max(maxPositionError, glm::length(pos - vertices[i].pos));
+
+			float length = glm::length(vertices[i].color);
+			if (length > FLT_EPSILON)
+			{
+				float cosine = glm::clamp(glm::dot(normal, vertices[i].color / length), -1.0f, 1.0f);
+				maxNormalError = std::max(maxNormalError, glm::degrees(acosf(cosine)));
+			}
+		}
+
+		return maxPositionError <= bound;
+	}
+
 	void calculateObjectBoundingBox(const std::vector<Vertex> &vertices, float *objectBboxMin, float *objectBboxMax)
 	{
 		for (int i = 0; i < vertices.size(); ++i)
@@ -1573,4 +1958,213 @@ namespace mm
 		}
 		}
 	}
+
+	// Post-pass for generateMeshlets. Underfilled meshlets (less than fillThreshold of the primitive limit)
+	// are merged with the neighbour they share the most vertices with, as long as the result still fits the limits.
+	// Returns the number of merges, the surviving meshlets keep their relative order.
+	uint32_t mergeMeshlets(std::vector<MeshletCache<uint32_t>> &meshlets, const Vertex *vertexBuffer, uint32_t primitiveLimit, uint32_t vertexLimit, float fillThreshold)
+	{
+		// which meshlets use a vertex, used to find the adjacent ones
+		std::unordered_map<uint32_t, std::vector<uint32_t>> vertexMeshlets;
+		for (uint32_t m = 0; m < meshlets.size(); ++m)
+		{
+			for (uint32_t v = 0; v < meshlets[m].numVertices; ++v)
+			{
+				vertexMeshlets[meshlets[m].vertices[v]].push_back(m);
+			}
+		}
+
+		std::vector<bool> alive(meshlets.size(), true);
+		uint32_t merges = 0;
+
+		bool merged = true;
+		while (merged)
+		{
+			merged = false;
+
+			for (uint32_t a = 0; a < meshlets.size(); ++a)
+			{
+				MeshletCache<uint32_t> &target = meshlets[a];
+				if (!alive[a] || target.numPrims >= primitiveLimit * fillThreshold)
+				{
+					continue;
+				}
+
+				std::unordered_map<uint32_t, uint32_t> shared;
+				for (uint32_t v = 0; v < target.numVertices; ++v)
+				{
+					for (uint32_t b : vertexMeshlets[target.vertices[v]])
+					{
+						if (b != a && alive[b])
+						{
+							shared[b]++;
+						}
+					}
+				}
+
+				uint32_t best = ~0u;
+				uint32_t bestShared = 0;
+				for (const auto &[b, count] : shared)
+				{
+					const MeshletCache<uint32_t> &other = meshlets[b];
+					bool fits = (target.numPrims + other.numPrims <= primitiveLimit) && (target.numVertices + other.numVertices - count <= vertexLimit);
+					if (fits && (count > bestShared || (count == bestShared && b < best)))
+					{
+						best = b;
+						bestShared = count;
+					}
+				}
+
+				if (best == ~0u)
+				{
+					continue;
+				}
+
+				const MeshletCache<uint32_t> &other = meshlets[best];
+				for (uint32_t p = 0; p < other.numPrims; ++p)
+				{
+					uint32_t indices[3] = {other.vertices[other.primitives[p][0]], other.vertices[other.primitives[p][1]], other.vertices[other.primitives[p][2]]};
+					target.insert(indices, vertexBuffer);
+				}
+
+				for (uint32_t v = 0; v < other.numVertices; ++v)
+				{
+					std::vector<uint32_t> &users = vertexMeshlets[other.vertices[v]];
+					if (std::find(users.begin(), users.end(), a) == users.end())
+					{
+						users.push_back(a);
+					}
+				}
+
+				alive[best] = false;
+				merges++;
+				merged = true;
+			}
+		}
+
+		size_t kept = 0;
+		for (size_t m = 0; m < meshlets.size(); ++m)
+		{
+			if (alive[m])
+			{
+				if (kept != m)
+				{
+					meshlets[kept] = meshlets[m];
+				}
+				kept++;
+			}
+		}
+		meshlets.resize(kept);
+
+		return merges;
+	}
+
+	// Spreads the low 10 bits of v so that there are two zero bits between every two of them
+	static uint32_t spreadBits(uint32_t v)
+	{
+		v &= 0x3FF;
+		v = (v | (v << 16)) & 0x030000FF;
+		v = (v | (v << 8)) & 0x0300F00F;
+		v = (v | (v << 4)) & 0x030C30C3;
+		v = (v | (v << 2)) & 0x09249249;
+		return v;
+	}
+
+	// Post-pass for generateMeshlets and mergeMeshlets. The greedy fill leaves neighbouring meshlets far apart in the
+	// list, sorting them along the Morton curve of their centers (the leaf order of a BVH split at the middle of every
+	// axis) stores the meshlets of a region next to each other, so a LoD cut selects a few long runs of indices.
+	// Everything packed afterwards and the index of every lod::Meshlet follow the new order.
+	void sortMeshletsSpatially(std::vector<MeshletCache<uint32_t>> &meshlets, const Vertex *vertexBuffer)
+	{
+		if (meshlets.size() <= 1)
+		{
+			return;
+		}
+
+		std::vector<glm::vec3> centers(meshlets.size());
+		glm::vec3 minPoint(std::numeric_limits<float>::max());
+		glm::vec3 maxPoint(-std::numeric_limits<float>::max());
+		for (size_t m = 0; m < meshlets.size(); ++m)
+		{
+			glm::vec3 sum(0.0f);
+			for (uint32_t v = 0; v < meshlets[m].numVertices; ++v)
+			{
+				sum += vertexBuffer[meshlets[m].vertices[v]].pos;
+			}
+			centers[m] = sum / float(std::max(meshlets[m].numVertices, 1u));
+
+			minPoint = glm::min(minPoint, centers[m]);
+			maxPoint = glm::max(maxPoint, centers[m]);
+		}
+
+		glm::vec3 extent = glm::max(maxPoint - minPoint, glm::vec3(1e-6f));
+
+		std::vector<uint32_t> codes(meshlets.size());
+		for (size_t m = 0; m < meshlets.size(); ++m)
+		{
+			glm::vec3 cell = glm::min((centers[m] - minPoint) / extent * 1024.0f, glm::vec3(1023.0f));
+			codes[m] = (spreadBits(uint32_t(cell.x)) << 2) | (spreadBits(uint32_t(cell.y)) << 1) | spreadBits(uint32_t(cell.z));
+		}
+
+		// Meshlets in the same cell keep the order they were filled in
+		std::vector<uint32_t> order(meshlets.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+						 { return codes[a] < codes[b]; });
+
+		std::vector<MeshletCache<uint32_t>> sorted;
+		sorted.reserve(meshlets.size());
+		for (uint32_t m : order)
+		{
+			sorted.push_back(meshlets[m]);
+		}
+		meshlets.swap(sorted);
+	}
+
+	// FNV-1a over the packed meshlet data and the vertices it indexes, equal hashes still need isSameGeometry.
+	// The vertices have to be in model space, a placement baked into them makes every copy unique
+	static uint64_t hashBytes(uint64_t hash, const void *data, size_t size)
+	{
+		const uint8_t *bytes = static_cast<const uint8_t *>(data);
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	uint64_t hashGeometry(const NVMeshlet::Builder<uint32_t>::MeshletGeometry &geometry, const mm::Vertex *vertices, size_t numVertices)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		hash = hashBytes(hash, geometry.meshletDescriptors.data(), geometry.meshletDescriptors.size() * sizeof(NVMeshlet::MeshletDesc));
+		hash = hashBytes(hash, geometry.primitiveIndices.data(), geometry.primitiveIndices.size() * sizeof(NVMeshlet::PrimitiveIndexType));
+		hash = hashBytes(hash, geometry.vertexIndices.data(), geometry.vertexIndices.size() * sizeof(uint32_t));
+
+		// field by field, the struct may have padding
+		for (size_t v = 0; v < numVertices; ++v)
+		{
+			hash = hashBytes(hash, &vertices[v].pos, sizeof(vertices[v].pos));
+			hash = hashBytes(hash, &vertices[v].color, sizeof(vertices[v].color));
+			hash = hashBytes(hash, &vertices[v].texCoord, sizeof(vertices[v].texCoord));
+		}
+
+		return hash;
+	}
+
+	bool isSameGeometry(const NVMeshlet::Builder<uint32_t>::MeshletGeometry &a, const mm::Vertex *verticesA, size_t numVerticesA,
+						const NVMeshlet::Builder<uint32_t>::MeshletGeometry &b, const mm::Vertex *verticesB, size_t numVerticesB)
+	{
+		if (a.meshletDescriptors.size() != b.meshletDescriptors.size() || a.primitiveIndices != b.primitiveIndices || a.vertexIndices != b.vertexIndices || numVerticesA != numVerticesB)
+		{
+			return false;
+		}
+
+		if (memcmp(a.meshletDescriptors.data(), b.meshletDescriptors.data(), a.meshletDescriptors.size() * sizeof(NVMeshlet::MeshletDesc)) != 0)
+		{
+			return false;
+		}
+
+		return std::equal(verticesA, verticesA + numVerticesA, verticesB);
+	}
 }
\ No newline at end of file
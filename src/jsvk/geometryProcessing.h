@@ -9,6 +9,7 @@
 
 #include "meshlet_builder.hpp"
 #include "structures.h"
+#include "config.h"
 
 // #include <headers/openvr.h>
 
@@ -21,6 +22,23 @@ std::vector<NVMeshlet::Builder<uint32_t>::MeshletGeometry> ConvertToMeshlet(std:
 
 namespace mm
 {
+    // size of one vertex in the vbo, the vertex offsets pushed to the mesh shader are in these units
+#if NVMESHLET_VERTEX_QUANTIZED
+    static const uint32_t VBO_VERTEX_STRIDE = NVMESHLET_VERTEX_QUANTIZED_STRIDE * sizeof(uint32_t);
+#else
+    static const uint32_t VBO_VERTEX_STRIDE = 3 * sizeof(float);
+#endif
+
+    // size of one element of the primitive index buffer as the mesh shader reads it and the
+    // primitive limit for the meshlet generation, strips are not restricted to 8 index fetches
+#if NVMESHLET_PRIMITIVE_STRIPS
+    static const uint32_t PRIM_FETCH_SIZE = sizeof(uint32_t);
+    static const uint32_t MESHLET_PRIMITIVE_LIMIT = NVMESHLET_PRIMITIVE_COUNT;
+#else
+    static const uint32_t PRIM_FETCH_SIZE = NVMeshlet::PRIMITIVE_INDICES_PER_FETCH;
+    static const uint32_t MESHLET_PRIMITIVE_LIMIT = 125;
+#endif
+
     struct AdjecencyInfo
     {
         std::vector<uint32_t> trianglesPerVertex;
@@ -32,8 +50,17 @@ namespace mm
     void collectStats(const NVMeshlet::Builder<uint32_t>::MeshletGeometry &geometry, std::vector<NVMeshlet::Stats> &stats);
     void generateEarlyCulling(NVMeshlet::Builder<uint32_t>::MeshletGeometry &geometry, const std::vector<Vertex> &vertices, std::vector<ObjectData> &objectData);
     NVMeshlet::Builder<uint32_t>::MeshletGeometry packNVMeshlets(const std::vector<mm::MeshletCache<uint32_t>> &meshlets);
+    bool packVertexIndicesDelta(NVMeshlet::Builder<uint32_t>::MeshletGeometry &geometry);
+    bool packPrimitiveStrips(NVMeshlet::Builder<uint32_t>::MeshletGeometry &geometry);
+    void quantizeVertices(const mm::Vertex *vertices, size_t numVertices, std::vector<uint32_t> &stream);
+    void dequantizeVertex(const uint32_t *stream, uint32_t vertex, glm::vec3 &pos, glm::vec3 &normal);
+    bool checkQuantizedVertices(const mm::Vertex *vertices, size_t numVertices, const uint32_t *stream, float &maxPositionError, float &maxNormalError);
     void loadTinyModel(const std::string &path, std::vector<Vertex> *vertices, std::vector<uint32_t> *indices);
     void generateMeshlets(std::unordered_map<unsigned int, Vert *> &indexVertexMap, std::vector<Triangle *> &triangles, std::vector<MeshletCache<uint32_t>> &mehslets, const Vertex *vertices, int strat = -1, uint32_t primitiveLimit = 125, uint32_t vertexLimit = 64);
+    uint64_t hashGeometry(const NVMeshlet::Builder<uint32_t>::MeshletGeometry &geometry, const mm::Vertex *vertices, size_t numVertices);
+    bool isSameGeometry(const NVMeshlet::Builder<uint32_t>::MeshletGeometry &a, const mm::Vertex *verticesA, size_t numVerticesA, const NVMeshlet::Builder<uint32_t>::MeshletGeometry &b, const mm::Vertex *verticesB, size_t numVerticesB);
+    uint32_t mergeMeshlets(std::vector<MeshletCache<uint32_t>> &meshlets, const Vertex *vertexBuffer, uint32_t primitiveLimit = 125, uint32_t vertexLimit = 64, float fillThreshold = 0.5f);
+    void sortMeshletsSpatially(std::vector<MeshletCache<uint32_t>> &meshlets, const Vertex *vertexBuffer);
     void makeMesh(std::unordered_map<unsigned int, Vert *> *indexVertexMap, std::vector<Triangle *> *triangles, const uint32_t numIndices, const uint32_t *indices);
 }
 #endif // HEADER_GUARD_GEOMETRYPROCESSING
\ No newline at end of file
@@ -3,8 +3,12 @@
 #include "jsvkHelpers.h"
 #include "lodCamera.hpp"
 #include "lodGeometry.hpp"
+#include "lodCulling.hpp"
+#include "lodOcclusion.hpp"
+#include "lodInstances.hpp"
+#include "lodSelection.hpp"
 #include "jsvkThreadpool.hpp"
-#include "lodThreadStealers.cpp"
+#include "lodThreadStealers.hpp"
 
 // STL includes
 #include <thread>
@@ -14,6 +18,8 @@
 #include <stack>
 #include <array>
 #include <chrono>
+#include <numeric>
+#include <algorithm>
 
 // External includes
 #include "omp.h"
@@ -24,6 +30,7 @@
 using namespace std::chrono_literals;
 
 extern int MAX_LOD;
+extern int CURRENTPIPE;
 
 extern int HOTRELOAD;
 extern bool INITIALIZED; // Have the simplified models been created?
@@ -32,12 +39,18 @@ extern int MESHLETS_DRAWN;
 extern int NO_TRIANGLES;
 
 extern int DRAW_CALLS;
+extern int BACKFACE_CULLED;
+extern int OCCLUSION_CULLED;
+extern float RECORD_TIME;
+extern float SELECTION_TIME;
+extern float SELECTION_LATENCY;
 
 extern lod::Camera camera;
 
 extern lod::World world;
 
-inline bool DistanceThresholds = true;
+inline bool ThreadedRecording = true; // Record the ranges on several threads instead of one buffer per range
+inline bool ReuseRecording = true;	  // Execute the buffers recorded for a swapchain image again while its draws and the pipeline stay the same
 
 namespace jsvk
 {
@@ -60,6 +73,20 @@ namespace jsvk
 	void VKRenderContext::deinit()
 	{
 		std::cout << "Destroying Render Context" << std::endl;
+
+		m_selectionThread.wait();
+
+		// Destroying a pool frees its command buffers
+		m_recordThreads.threads.clear();
+		for (auto &frameData : m_threadData)
+		{
+			for (auto &data : frameData)
+			{
+				vkDestroyCommandPool(m_pVulkanDevice->Device(), data.cmdPool, nullptr);
+			}
+		}
+		m_threadData.clear();
+
 		// Destroy renderframes
 		if (m_renderFrames.size() > 0)
 		{
@@ -77,188 +104,281 @@ namespace jsvk
 	}
 
 	// Traverse the DAG in order to draw
+	// The workers persist between traversals, a node is claimed in visited before it is enqueued and every worker
+	// collects the nodes it selects in its own list (the last list is for the calling thread) that are merged afterwards
 	lod::ThreadPool threadPool(std::thread::hardware_concurrency());
-	std::unordered_set<uint16_t> visited;
+	lod::AtomicBitset visited; // One flag per node of the mesh of every visible instance, see visibleBegin
+	std::vector<std::vector<uint64_t>> workerDrawn(threadPool.size() + 1);
 
-	// std::vector<std::vector<lod::Graph::Node>> threads_drawing(10);
+	std::vector<uint64_t> drawn{}; // The instances and DAG nodes selected to be drawn, see lod::drawnKey
 
-	std::vector<lod::Graph::Node *> drawn{};
+	std::vector<uint64_t> rangeKeys; // See lod::rangeKey
+	std::vector<uint32_t> rangeNodes; // The DAG node of every key, for the triangle counts
+	lod::RangeSortScratch rangeScratch;
 
-	std::mutex mtx;
-	std::mutex mtx_drawn;
-	std::mutex mtx_visited;
+	lod::FrustumPlanes frustumPlanes; // The camera frustum of the current traversal
 
-	// Returns true if the AABB is in the frustum
-	bool isAABBInFrustum(const lod::BoundingBox &aabb, const lod::Frustum &frustum)
-	{
-		std::array<lod::Plane, 6> planes = {frustum.left, frustum.right, frustum.top, frustum.bottom, frustum.near, frustum.far};
+	std::vector<lod::InstanceView> instanceViews; // Only up to date for the visible instances
+
+	// Instance culling
+	// The instances are culled against the frustum and camera.cullDistance through a BVH over their world space boxes
+	// before any DAG is looked at, so the selection only ever starts from the instances that can be seen
+	lod::InstanceBVH instanceBVH;
+	std::vector<uint32_t> visibleInstances; // The instances that survived the BVH, in increasing order
+	std::vector<uint8_t> instanceVisible;	 // Per instance, 1 when it is in visibleInstances
 
-		for (const auto &plane : planes)
+	// The per node state of a selection only covers the nodes of the mesh of every visible instance, one visible instance
+	// after the other. The state of node n of instance i is at visibleBegin[i] + DAG.meshNodes[n]
+	std::vector<size_t> visibleBegin; // Per instance, only up to date for the visible ones
+	size_t visibleNodes = 0;		  // The nodes of the meshes of all visible instances
+
+	// The moves of setObjectData, only called while no selection runs
+	void applyInstanceMoves()
+	{
+		for (const auto &[i, move] : world.pendingMoves)
 		{
-			glm::vec3 positiveVertex = aabb.minPoint;
-			glm::vec3 negativeVertex = aabb.maxPoint;
+			lod::Instance &instance = world.instances[i];
+			instance.transform = move * instance.transform;
+			instance.inverse = glm::inverse(instance.transform);
 
-			if (plane.normal.x >= 0)
+			if (i < world.mesh_centers.size())
 			{
-				positiveVertex.x = aabb.maxPoint.x;
-				negativeVertex.x = aabb.minPoint.x;
+				world.mesh_centers[i] = glm::vec3(move * glm::vec4(world.mesh_centers[i], 1.0f));
 			}
-			if (plane.normal.y >= 0)
+			if (world.instance_bounds.size() == world.instances.size())
+			{
+				world.instance_bounds.set(i, lod::transformBounds(world.mesh_bounds[instance.mesh], instance.transform));
+				world.movedInstances.push_back(i);
+			}
+		}
+		world.pendingMoves.clear();
+	}
+
+	void selectInstances(const lod::Camera *camera)
+	{
+		visibleInstances.clear();
+		instanceVisible.assign(world.instances.size(), 0);
+
+		// Without a DAG there are no instance bounds and everything is visible
+		if (world.instance_bounds.size() != world.instances.size())
+		{
+			visibleInstances.resize(world.instances.size());
+			std::iota(visibleInstances.begin(), visibleInstances.end(), 0);
+		}
+		else
+		{
+			// Built again when instances were added or removed, moved instances only refit the boxes
+			if (instanceBVH.instanceCount() != world.instances.size())
 			{
-				positiveVertex.y = aabb.maxPoint.y;
-				negativeVertex.y = aabb.minPoint.y;
+				instanceBVH.build(world.instance_bounds, std::thread::hardware_concurrency());
 			}
-			if (plane.normal.z >= 0)
+			else if (!world.movedInstances.empty())
 			{
-				positiveVertex.z = aabb.maxPoint.z;
-				negativeVertex.z = aabb.minPoint.z;
+				instanceBVH.refit(world.instance_bounds, world.movedInstances);
 			}
+			world.movedInstances.clear();
 
-			if (glm::dot(plane.normal, positiveVertex) + plane.distance < 0)
-				return false;
+			instanceBVH.query(world.instance_bounds, frustumPlanes, camera->position, camera->cullDistance, visibleInstances);
+			std::sort(visibleInstances.begin(), visibleInstances.end());
 		}
 
-		// If we haven't found a separating plane where the entire AABB is outside, then the AABB is in the frustum
-		return true;
-	}
+		instanceViews.resize(world.instances.size());
 
-	// This is the standard BFS search algorithm it chooses to draw based on screen space error of switching to the next LoD
-	void processNode_SSE(lod::Graph::Node *node, lod::Camera *camera)
-	{
-		if (!(isAABBInFrustum(node->bb, camera->frustum)))
+		for (uint32_t i : visibleInstances)
 		{
-			return;
+			const lod::Instance &instance = world.instances[i];
+
+			instanceVisible[i] = 1;
+			instanceViews[i].position = glm::vec3(instance.inverse * glm::vec4(camera->position, 1.0f));
+			instanceViews[i].planes = lod::FrustumPlanes(camera->frustum, instance.transform);
+			instanceViews[i].mesh = instance.mesh;
 		}
 
-		// The bottom of the tree has been reached and now all meshlets need to be drawn
-		if (node->children.size() == 0)
+		visibleBegin.resize(world.instances.size());
+		visibleNodes = 0;
+		for (uint32_t i : visibleInstances)
 		{
-			mtx.lock();
-			drawn.push_back(node);
-			mtx.unlock();
-			return;
+			visibleBegin[i] = visibleNodes;
+			visibleNodes += world.DAG.meshSize(world.instances[i].mesh);
 		}
+	}
 
-		// Process node here.
-		bool checkChildren = false;
-		bool draw = false;
-
-		float d = glm::distance(camera->position, node->center);
+	std::atomic<int> backfaceCulled{0}; // Clusters the last selection dropped because they face away from the camera
 
-		float nodeSize = glm::length(node->bb.maxPoint - node->bb.minPoint); // Diagonal length of the node
-		float angle = atan(nodeSize / 2.0f / d);
-		float pixelWidth = (angle / camera->fov) * camera->res.x;
-
-		// Don't check nodes that are too small
-		if (pixelWidth < camera->pixelThreshold)
+	// The normal cone test the task shader does per meshlet, done here so the cluster never reaches drawDynamic
+	bool cullBackfacing(uint32_t instance, uint32_t node, const lod::Camera *camera)
+	{
+		if (camera->backfaceCulling && lod::isBackfacing(world.DAG.cones[node], world.DAG.bounds[node], instanceViews[instance].position))
 		{
-			return;
+			backfaceCulled++;
+			return true;
 		}
 
-		float lod_error = world.simplification_errors[node->lod];
+		return false;
+	}
 
-		angle = atan(lod_error / d) * 180 / 3.141592653589793238463;
+	void processNode_SSE(uint32_t instance, uint32_t node, lod::Camera *camera, bool inside);
+	void processNode_distance(uint32_t instance, uint32_t node, lod::Camera *camera, bool inside);
 
-		float SSE = (angle / camera->fov) * (camera->res.x * camera->res.y);
+	// Claims the nodes, culls the claimed ones against the frustum in one batch and enqueues the visible ones
+	// The nodes below a parent that was completely inside the frustum are not tested again if they lie within
+	// the bounds of the parent, the DAG links overlapping clusters so a child can reach outside of its parent
+	void enqueueNodes(uint32_t instance, uint32_t parent, const uint32_t *nodes, uint32_t count, bool inside, lod::Camera *camera)
+	{
+		thread_local std::vector<uint32_t> claimed;
+		thread_local std::vector<lod::CullResult> results;
 
-		float threshold = camera->thresholds[node->lod];
+		const size_t instanceBegin = visibleBegin[instance];
 
-		if (d < threshold)
+		claimed.clear();
+		for (uint32_t i = 0; i < count; i++)
 		{
-			checkChildren = true;
+			if (visited.set(instanceBegin + world.DAG.meshNodes[nodes[i]]))
+			{
+				claimed.push_back(nodes[i]);
+			}
 		}
-		else
+
+		// The nodes that need the frustum test go first
+		auto tested = claimed.end();
+		if (inside)
+		{
+			const lod::BoundingBox parentBounds = world.DAG.bounds[parent];
+			tested = std::partition(claimed.begin(), claimed.end(), [&](uint32_t node)
+									{ return !parentBounds.contains(world.DAG.bounds[node]); });
+		}
+
+		results.assign(claimed.size(), lod::CULL_INSIDE);
+		lod::cullBounds(instanceViews[instance].planes, world.DAG.bounds, claimed.data(), uint32_t(tested - claimed.begin()), results.data());
+
+		for (size_t i = 0; i < claimed.size(); i++)
 		{
-			if (SSE < camera->SSEThreshold)
+			if (results[i] == lod::CULL_OUTSIDE)
 			{
+				continue;
+			}
 
-				draw = true;
+			uint32_t node = claimed[i];
+			bool nodeInside = results[i] == lod::CULL_INSIDE;
+
+			if (camera->distanceThresholds)
+			{
+				threadPool.enqueue([=]()
+								   { processNode_distance(instance, node, camera, nodeInside); });
 			}
 			else
 			{
-				checkChildren = true;
+				threadPool.enqueue([=]()
+								   { processNode_SSE(instance, node, camera, nodeInside); });
 			}
 		}
+	}
 
-		// Add child nodes to the next LoD traversal
-		if (checkChildren)
+	// What a node wants to do for the current camera, shared by the traversal and the incremental cut
+	enum NodeDecision
+	{
+		NODE_DRAW,	 // Draw the node itself
+		NODE_REFINE, // Replace the node with its children
+		NODE_SKIP,	 // Too small on screen to draw
+	};
+
+	// Chooses based on screen space error of switching to the next LoD
+	NodeDecision decideNode_SSE(uint32_t instance, uint32_t node, const lod::Camera *camera)
+	{
+		const lod::Graph::DAG &dag = world.DAG;
+		const lod::BoundingBox bb = dag.bounds[node];
+
+		// The bottom of the tree has been reached and now all meshlets need to be drawn
+		if (dag.childCount(node) == 0)
 		{
+			return NODE_DRAW;
+		}
 
-			for (auto &child : node->children)
-			{
-				mtx.lock();
-				if (visited.count(child.second->id) == 0)
-				{
-					visited.insert(child.second->id);
-					threadPool.enqueue([=, &child]()
-									   { processNode_SSE(child.second, camera); });
-				}
-				mtx.unlock();
-			}
+		float d = glm::distance(instanceViews[instance].position, dag.centers[node]);
+
+		float nodeSize = glm::length(bb.maxPoint - bb.minPoint); // Diagonal length of the node
+		float angle = atan(nodeSize / 2.0f / d);
+		float pixelWidth = (angle / camera->fov) * camera->res.x;
+
+		// Don't check nodes that are too small
+		if (pixelWidth < camera->pixelThreshold)
+		{
+			return NODE_SKIP;
 		}
 
-		if (draw)
+		float lod_error = dag.errors[node];
+
+		angle = atan(lod_error / d) * 180 / 3.141592653589793238463;
+
+		float SSE = (angle / camera->fov) * (camera->res.x * camera->res.y);
+
+		float threshold = camera->thresholds[dag.lods[node]] / camera->frameTime.scale;
+
+		if ((d >= threshold) && (SSE < camera->SSEThreshold * camera->frameTime.scale))
 		{
-			mtx.lock();
-			drawn.push_back(node);
-			mtx.unlock();
+			return NODE_DRAW;
 		}
+
+		return NODE_REFINE;
 	}
 
-	// This is the standard BFS search algorithm it chooses to draw based on the distance to the camera
-	void processNode_distance(lod::Graph::Node *node, lod::Camera *camera)
+	// Chooses based on the distance to the camera
+	NodeDecision decideNode_distance(uint32_t instance, uint32_t node, const lod::Camera *camera)
 	{
-		if (!(isAABBInFrustum(node->bb, camera->frustum)))
-		{
-			return;
-		}
+		const lod::Graph::DAG &dag = world.DAG;
 
 		// The bottom of the tree has been reached and now all meshlets need to be drawn
-		if (node->lod == 0)
+		if (dag.lods[node] == 0)
 		{
-			mtx.lock();
-			drawn.push_back(node);
-			mtx.unlock();
-			return;
+			return NODE_DRAW;
 		}
 
-		// Process node here.
-		bool checkChildren = false;
-		bool draw = false;
+		float d = glm::distance(instanceViews[instance].position, dag.centers[node]);
+		float threshold = camera->thresholds[dag.lods[node]] / camera->frameTime.scale;
 
-		float d = glm::distance(camera->position, node->center);
-		float threshold = camera->thresholds[node->lod];
+		return (d < threshold) ? NODE_REFINE : NODE_DRAW;
+	}
+
+	NodeDecision decideNode(uint32_t instance, uint32_t node, const lod::Camera *camera)
+	{
+		return camera->distanceThresholds ? decideNode_distance(instance, node, camera) : decideNode_SSE(instance, node, camera);
+	}
+
+	// This is the standard BFS search algorithm it chooses to draw based on screen space error of switching to the next LoD
+	// The node has already passed the frustum test in enqueueNodes
+	void processNode_SSE(uint32_t instance, uint32_t node, lod::Camera *camera, bool inside)
+	{
+		const lod::Graph::DAG &dag = world.DAG;
 
-		if (d < threshold)
+		NodeDecision decision = decideNode_SSE(instance, node, camera);
+
+		// Add child nodes to the next LoD traversal
+		if (decision == NODE_REFINE)
 		{
-			checkChildren = true;
+			enqueueNodes(instance, node, dag.children.data() + dag.childBegin[node], dag.childCount(node), inside, camera);
 		}
-		else
+		else if ((decision == NODE_DRAW) && !cullBackfacing(instance, node, camera))
 		{
-			draw = true;
+			workerDrawn[threadPool.currentWorker()].push_back(lod::drawnKey(instance, node));
 		}
+	}
+
+	// This is the standard BFS search algorithm it chooses to draw based on the distance to the camera
+	// The node has already passed the frustum test in enqueueNodes
+	void processNode_distance(uint32_t instance, uint32_t node, lod::Camera *camera, bool inside)
+	{
+		const lod::Graph::DAG &dag = world.DAG;
+
+		NodeDecision decision = decideNode_distance(instance, node, camera);
 
 		// Add child nodes to the next LoD traversal
-		if (checkChildren)
+		if (decision == NODE_REFINE)
 		{
-
-			for (auto &child : node->children)
-			{
-				mtx.lock();
-				if (visited.count(child.second->id) == 0)
-				{
-					visited.insert(child.second->id);
-					threadPool.enqueue([=, &child]()
-									   { processNode_distance(child.second, camera); });
-				}
-				mtx.unlock();
-			}
+			enqueueNodes(instance, node, dag.children.data() + dag.childBegin[node], dag.childCount(node), inside, camera);
 		}
-
-		if (draw)
+		else if ((decision == NODE_DRAW) && !cullBackfacing(instance, node, camera))
 		{
-			mtx.lock();
-			drawn.push_back(node);
+			workerDrawn[threadPool.currentWorker()].push_back(lod::drawnKey(instance, node));
 
 			// The dream would be this done here
 			// camera.offset = node->lod; // The start of the LoD indices and vertices
@@ -280,11 +400,392 @@ namespace jsvk
 			// {
 			// 	break;
 			// }
+		}
+	}
+
+	// Incremental LoD selection
+	// The cut is the set of nodes selected in the previous frames. Every frame up to CUT_BUDGET of them are looked at
+	// again, round robin: a node that wants to refine is replaced by its children and a node with an ancestor that would
+	// rather be drawn itself is replaced by that ancestor, together with every other descendant of the ancestor in the cut.
+	// The cost follows how much of the cut changes and not the size of the scene.
+	const uint32_t CUT_BUDGET = 4096;
+
+	// The cut outlives the visibility of its instances, so its state covers the nodes of the mesh of every instance and
+	// the state of node n of instance i is at cutBegin[i] + DAG.meshNodes[n]
+	std::vector<uint64_t> cut;		// The instances and nodes in the cut, in no particular order
+	std::vector<size_t> cutBegin;	// Per instance, where the state of its nodes starts
+	std::vector<uint8_t> cutState;	// Per node of the mesh of every instance, 0 not in the cut, CUT_MEMBER in the cut, CUT_MEMBER | CUT_HIDDEN in the cut but too small to draw
+	std::vector<uint32_t> cutSlot;	// Per node of the mesh of every instance, where it is in the cut while it is a member
+	std::vector<uint32_t> cutVisit; // Per node, the last coarsening that walked over it
+	uint32_t cutVisitStamp = 0;
+	size_t cutCursor = 0;			// Where the next frame continues re-evaluating the cut
+
+	const uint8_t CUT_MEMBER = 1;
+	const uint8_t CUT_HIDDEN = 2;
+
+	size_t cutIndex(uint32_t instance, uint32_t node)
+	{
+		return cutBegin[instance] + world.DAG.meshNodes[node];
+	}
+
+	void addToCut(uint32_t instance, uint32_t node)
+	{
+		size_t index = cutIndex(instance, node);
+		cutState[index] = CUT_MEMBER;
+		cutSlot[index] = uint32_t(cut.size());
+		cut.push_back(lod::drawnKey(instance, node));
+	}
+
+	// The last node of the cut takes the place of the removed one
+	void removeFromCut(uint32_t instance, uint32_t node)
+	{
+		size_t index = cutIndex(instance, node);
+		uint32_t slot = cutSlot[index];
+
+		uint64_t last = cut.back();
+		cut[slot] = last;
+		cutSlot[cutIndex(lod::drawnInstance(last), lod::drawnNode(last))] = slot;
+		cut.pop_back();
+
+		cutState[index] = 0;
+	}
+
+	// Removes every node below target from the cut, also the ones below nodes that are not in the cut themselves
+	void removeDescendants(uint32_t instance, uint32_t target)
+	{
+		const lod::Graph::DAG &dag = world.DAG;
+
+		// A node with several parents is only walked once
+		if (++cutVisitStamp == 0)
+		{
+			std::fill(cutVisit.begin(), cutVisit.end(), 0);
+			cutVisitStamp = 1;
+		}
+
+		thread_local std::vector<uint32_t> stack;
+		stack.assign(dag.children.begin() + dag.childBegin[target], dag.children.begin() + dag.childBegin[target + 1]);
+
+		while (!stack.empty())
+		{
+			uint32_t node = stack.back();
+			stack.pop_back();
+
+			if (cutVisit[node] == cutVisitStamp)
+			{
+				continue;
+			}
+			cutVisit[node] = cutVisitStamp;
+
+			if (cutState[cutIndex(instance, node)] != 0)
+			{
+				removeFromCut(instance, node);
+			}
 
-			mtx.unlock();
+			stack.insert(stack.end(), dag.children.begin() + dag.childBegin[node], dag.children.begin() + dag.childBegin[node + 1]);
 		}
 	}
 
+	void updateCut(const lod::Camera *camera, uint32_t budget)
+	{
+		const lod::Graph::DAG &dag = world.DAG;
+
+		// Start from the roots the first time or when the DAG or the instances changed
+		if ((cutBegin.size() != world.instances.size() + 1) || (cutVisit.size() != dag.size()))
+		{
+			cutBegin.assign(1, 0);
+			for (const lod::Instance &instance : world.instances)
+			{
+				cutBegin.push_back(cutBegin.back() + dag.meshSize(instance.mesh));
+			}
+
+			cutState.assign(cutBegin.back(), 0);
+			cutSlot.assign(cutBegin.back(), 0);
+			cutVisit.assign(dag.size(), 0);
+			cutVisitStamp = 0;
+			cut.clear();
+			for (uint32_t instance = 0; instance < world.instances.size(); instance++)
+			{
+				const uint32_t mesh = world.instances[instance].mesh;
+				for (uint32_t root = dag.meshLevelFirst(mesh, MAX_LOD); root < dag.meshLevelEnd(mesh, MAX_LOD); root++)
+				{
+					addToCut(instance, root);
+				}
+			}
+			cutCursor = 0;
+		}
+
+		// A locked camera keeps the cut it has
+		if (camera->locked)
+		{
+			return;
+		}
+
+		uint32_t evaluations = uint32_t(std::min<size_t>(budget, cut.size()));
+
+		for (uint32_t e = 0; (e < evaluations) && !cut.empty(); e++)
+		{
+			if (cutCursor >= cut.size())
+			{
+				cutCursor = 0;
+			}
+
+			uint32_t instance = lod::drawnInstance(cut[cutCursor]);
+			uint32_t node = lod::drawnNode(cut[cutCursor]);
+
+			// The nodes of culled instances keep their place in the cut until the instance is seen again
+			if (!instanceVisible[instance])
+			{
+				cutCursor++;
+				continue;
+			}
+
+			// The states of the nodes of this instance
+			auto state = [instance](uint32_t node) -> uint8_t &
+			{ return cutState[cutIndex(instance, node)]; };
+
+			NodeDecision decision = decideNode(instance, node, camera);
+
+			// Walk up the first parents to the coarsest node the traversal would have stopped at
+			uint32_t target = node;
+			for (uint32_t ancestor = node; dag.parentCount(ancestor) > 0;)
+			{
+				ancestor = dag.parents[dag.parentBegin[ancestor]];
+				if ((state(ancestor) != 0) || (decideNode(instance, ancestor, camera) != NODE_REFINE))
+				{
+					target = ancestor;
+				}
+			}
+
+			// Like the traversal, nodes outside the frustum are not refined
+			lod::CullResult visibility;
+			lod::cullBounds_scalar(instanceViews[instance].planes, dag.bounds, &node, 1, &visibility);
+
+			// Removed nodes are replaced by the last node of the cut, which is looked at next
+			if (target != node)
+			{
+				// Coarsen, target replaces all of its descendants in the cut, this node among them
+				if (state(target) == 0)
+				{
+					addToCut(instance, target);
+				}
+				removeDescendants(instance, target);
+			}
+			else if ((decision == NODE_REFINE) && (dag.childCount(node) > 0) && (visibility != lod::CULL_OUTSIDE))
+			{
+				removeFromCut(instance, node);
+				for (uint32_t c = dag.childBegin[node]; c < dag.childBegin[node + 1]; c++)
+				{
+					uint32_t child = dag.children[c];
+					if (state(child) == 0)
+					{
+						addToCut(instance, child);
+					}
+				}
+			}
+			else
+			{
+				state(node) = CUT_MEMBER | ((decision == NODE_SKIP) ? CUT_HIDDEN : 0);
+				cutCursor++;
+			}
+		}
+	}
+
+	// Flat LoD selection
+	// A node is drawn when its own error is small enough and the error of its parents is not. The errors and their
+	// spheres only grow going up the DAG so the test of a node never disagrees with the test of its parents, which lets
+	// every node be tested on its own: the nodes of the mesh of every visible instance are split in chunks over the pool
+	// and concatenated in instance and id order afterwards.
+	const uint32_t FLAT_CUT_CHUNK = 4096;
+
+	std::vector<std::vector<uint32_t>> chunkDrawn; // The nodes selected by every chunk
+	std::vector<uint32_t> chunkBegin;			   // The chunks of visibleInstances[i] are [chunkBegin[i], chunkBegin[i + 1])
+
+	void selectFlatCut(const lod::Camera *camera)
+	{
+		const lod::Graph::DAG &dag = world.DAG;
+
+		// The pixel threshold as an angle, errors are compared without converting them to pixels
+		const float threshold = camera->errorThreshold * camera->frameTime.scale * 2.0f * tan(glm::radians(camera->fov) * 0.5f) / float(camera->res.y);
+
+		chunkBegin.assign(1, 0);
+		for (uint32_t instance : visibleInstances)
+		{
+			chunkBegin.push_back(chunkBegin.back() + (dag.meshSize(world.instances[instance].mesh) + FLAT_CUT_CHUNK - 1) / FLAT_CUT_CHUNK);
+		}
+		chunkDrawn.resize(chunkBegin.back());
+
+		for (uint32_t slot = 0; slot < visibleInstances.size(); slot++)
+		{
+			for (uint32_t task = chunkBegin[slot]; task < chunkBegin[slot + 1]; task++)
+			{
+				threadPool.enqueue([=]()
+								   {
+				const lod::Graph::DAG &dag = world.DAG;
+				const uint32_t instance = visibleInstances[slot];
+				const uint32_t mesh = world.instances[instance].mesh;
+				const lod::InstanceView &view = instanceViews[instance];
+
+				std::vector<uint32_t> &selected = chunkDrawn[task];
+				selected.clear();
+
+				// The chunk counts the nodes of the mesh one LoD after the other
+				const uint32_t chunkFirst = (task - chunkBegin[slot]) * FLAT_CUT_CHUNK;
+				const uint32_t chunkLast = chunkFirst + FLAT_CUT_CHUNK;
+
+				uint32_t levelOffset = 0;
+				for (int level = 0; (level < int(dag.levels())) && (levelOffset < chunkLast); level++)
+				{
+					const uint32_t levelFirst = dag.meshLevelFirst(mesh, level);
+					const uint32_t levelCount = dag.meshLevelEnd(mesh, level) - levelFirst;
+
+					uint32_t first = levelFirst + std::min(levelCount, std::max(chunkFirst, levelOffset) - levelOffset);
+					uint32_t last = levelFirst + std::min(levelCount, chunkLast - levelOffset);
+					levelOffset += levelCount;
+
+					for (uint32_t node = first; node < last; node++)
+					{
+						bool fineEnough = (dag.childCount(node) == 0) || (lod::projectedError(dag.errors[node], dag.errorSpheres[node], view.position, camera->near) <= threshold);
+						bool parentTooCoarse = lod::projectedError(dag.parentErrors[node], dag.parentSpheres[node], view.position, camera->near) > threshold;
+
+						if (fineEnough && parentTooCoarse)
+						{
+							selected.push_back(node);
+						}
+					}
+				}
+
+				// Frustum and backface cull the selection of the chunk and compact it in place
+				thread_local std::vector<lod::CullResult> results;
+				results.resize(selected.size());
+				lod::cullBounds(view.planes, dag.bounds, selected.data(), uint32_t(selected.size()), results.data());
+
+				size_t visible = 0;
+				for (size_t i = 0; i < selected.size(); i++)
+				{
+					if ((results[i] != lod::CULL_OUTSIDE) && !cullBackfacing(instance, selected[i], camera))
+					{
+						selected[visible++] = selected[i];
+					}
+				}
+				selected.resize(visible); });
+			}
+		}
+
+		threadPool.wait();
+
+		drawn.clear();
+		for (uint32_t slot = 0; slot < visibleInstances.size(); slot++)
+		{
+			for (uint32_t task = chunkBegin[slot]; task < chunkBegin[slot + 1]; task++)
+			{
+				for (uint32_t node : chunkDrawn[task])
+				{
+					drawn.push_back(lod::drawnKey(visibleInstances[slot], node));
+				}
+			}
+		}
+	}
+
+	// Budgeted LoD selection, see lod::selectBudgetCut
+	std::vector<uint8_t> budgetState; // A lod::BudgetState per node of the mesh of every visible instance
+
+	void selectBudgetCut(const lod::Camera *camera)
+	{
+		drawn.clear();
+		lod::selectBudgetCut(world.DAG, visibleInstances, instanceViews, uint64_t(camera->triangleBudget / camera->frameTime.scale), camera->near, budgetState, drawn);
+
+		// Clusters facing away still count against the budget, they only take no draw range
+		drawn.erase(std::remove_if(drawn.begin(), drawn.end(), [camera](uint64_t key)
+								   { return cullBackfacing(lod::drawnInstance(key), lod::drawnNode(key), camera); }),
+					drawn.end());
+
+		std::sort(drawn.begin(), drawn.end());
+	}
+
+	// Occlusion culling
+	// The coarsest LoD of the instances nearest to the camera is rasterized into a small depth buffer on the pool, one task
+	// per band of rows, and the selected nodes whose box is behind it are dropped. The occluders are capped so that
+	// the pass stays a fixed cost on top of the selection.
+	const uint32_t OCCLUSION_WIDTH = 256;		// Pixels across, the height follows the aspect ratio of the camera
+	const uint32_t OCCLUDER_INSTANCES = 16;		// Nearest instances that occlude
+	const uint32_t OCCLUDER_TRIANGLES = 32'768; // Triangles rasterized per frame at most
+
+	lod::OcclusionBuffer occlusionBuffer;
+	std::vector<glm::vec3> occluderPositions;
+	std::vector<float> occluderMargins;
+
+	int occlusionCulled = 0; // Clusters the last selection dropped behind the occluders
+
+	void cullOccluded(const lod::Camera *camera)
+	{
+		occlusionCulled = 0;
+
+		if (!camera->occlusionCulling || (world.occluderBegin.size() < 2) || drawn.empty())
+		{
+			return;
+		}
+
+		// The visible instances nearest to the camera
+		std::vector<std::pair<float, uint32_t>> candidates;
+		for (uint32_t instance : visibleInstances)
+		{
+			lod::BoundingBox bb = world.instance_bounds[instance];
+			candidates.push_back({glm::length((bb.minPoint + bb.maxPoint) * 0.5f - camera->position), instance});
+		}
+
+		size_t nearest = std::min<size_t>(OCCLUDER_INSTANCES, candidates.size());
+		std::partial_sort(candidates.begin(), candidates.begin() + nearest, candidates.end());
+
+		// The occluders are stored once per mesh in model space and are moved to world space for every instance
+		occluderPositions.clear();
+		occluderMargins.clear();
+		for (size_t i = 0; i < nearest; i++)
+		{
+			const lod::Instance &instance = world.instances[candidates[i].second];
+			uint32_t first = world.occluderBegin[instance.mesh];
+			uint32_t last = world.occluderBegin[instance.mesh + 1];
+
+			if (occluderMargins.size() + (last - first) > OCCLUDER_TRIANGLES)
+			{
+				break;
+			}
+
+			for (uint32_t v = 3 * first; v < 3 * last; v++)
+			{
+				occluderPositions.push_back(glm::vec3(instance.transform * glm::vec4(world.occluderPositions[v], 1.0f)));
+			}
+			occluderMargins.insert(occluderMargins.end(), world.occluderMargins.begin() + first, world.occluderMargins.begin() + last);
+		}
+
+		if (occluderMargins.empty())
+		{
+			return;
+		}
+
+		occlusionBuffer.resize(OCCLUSION_WIDTH, float(camera->res.x) / float(camera->res.y));
+		occlusionBuffer.setup(camera->projection * camera->view, camera->near, occluderPositions, occluderMargins);
+
+		for (uint32_t band = 0; band < occlusionBuffer.bandCount(); band++)
+		{
+			threadPool.enqueue([band]()
+							   { occlusionBuffer.rasterizeBand(band); });
+		}
+		threadPool.wait();
+
+		size_t visible = 0;
+		for (uint64_t key : drawn)
+		{
+			const lod::Instance &instance = world.instances[lod::drawnInstance(key)];
+			if (occlusionBuffer.isVisible(lod::transformBounds(world.DAG.bounds[lod::drawnNode(key)], instance.transform)))
+			{
+				drawn[visible++] = key;
+			}
+		}
+
+		occlusionCulled = int(drawn.size() - visible);
+		drawn.resize(visible);
+	}
+
 	std::atomic<bool> lock{false};
 	// TODO: make synchronization better as this is definitely not production ready
 	auto sleep = 0.005ns;
@@ -366,6 +867,198 @@ namespace jsvk
 	// 	}
 	// }
 
+	// Pipelined selection
+	// The LoD selection and the coalescing of its ranges write their own state only, so the selection for the next
+	// frame runs on its own thread from a camera moved and turned ahead by its velocities while the current frame is
+	// drawn with the selection made during the last one. The two selections are double buffered, Render swaps them once
+	// the thread is done
+	struct Selection
+	{
+		std::vector<uint64_t> keys;	 // The sorted range keys of the selected clusters
+		std::vector<uint32_t> nodes;	 // The DAG node of every key
+		std::vector<uint32_t> visible; // The instances that survived the BVH
+		int singleLOD = -1;			 // The LoD of the selection when it is drawn as discrete LoD, -1 to draw the ranges
+
+		int backfaceCulled = 0;
+		int occlusionCulled = 0;
+		std::chrono::steady_clock::time_point lastUpdateTime;
+
+		std::chrono::steady_clock::time_point sampled; // When the camera was taken, for the latency
+		float selectMs = 0.0f;						   // How long the selection took
+	};
+
+	Selection selections[2];
+	uint32_t frontSelection = 0;	// The selection drawn this frame, the other one is the one being selected
+	bool selectionPending = false; // The back selection was started and has to be swapped in
+
+	void selectLOD(lod::Camera &camera, Selection &selection)
+	{
+		selection.sampled = std::chrono::steady_clock::now();
+
+		frustumPlanes = lod::FrustumPlanes(camera.frustum);
+		selectInstances(&camera);
+
+		if (camera.selection == lod::SELECTION_BUDGET)
+		{
+			backfaceCulled = 0;
+
+			selectBudgetCut(&camera);
+			cullOccluded(&camera);
+
+			camera.lastUpdateTime = std::chrono::steady_clock::now();
+		}
+		else if (camera.selection == lod::SELECTION_FLAT)
+		{
+			backfaceCulled = 0;
+
+			// Chunks are concatenated in id order so drawn is already sorted
+			selectFlatCut(&camera);
+			cullOccluded(&camera);
+
+			camera.lastUpdateTime = std::chrono::steady_clock::now();
+		}
+		else if (camera.selection == lod::SELECTION_INCREMENTAL)
+		{
+			// The cut changes a little every frame so there is no need for the velocity delay
+			backfaceCulled = 0;
+
+			updateCut(&camera, CUT_BUDGET);
+
+			// Every node is tested against the frustum of its own instance
+			drawn.clear();
+			for (uint64_t key : cut)
+			{
+				uint32_t instance = lod::drawnInstance(key);
+				uint32_t node = lod::drawnNode(key);
+
+				if (!instanceVisible[instance])
+				{
+					continue;
+				}
+
+				lod::CullResult visibility;
+				lod::cullBounds_scalar(instanceViews[instance].planes, world.DAG.bounds, &node, 1, &visibility);
+
+				if ((visibility != lod::CULL_OUTSIDE) && !(cutState[cutIndex(instance, node)] & CUT_HIDDEN) && !cullBackfacing(instance, node, &camera))
+				{
+					drawn.push_back(key);
+				}
+			}
+			std::sort(drawn.begin(), drawn.end());
+
+			cullOccluded(&camera);
+
+			camera.lastUpdateTime = std::chrono::steady_clock::now();
+		}
+		// SELECTION_TRAVERSAL, the DAG is traversed again once the camera moved or nothing was selected yet
+		else if (((camera.velocity != glm::vec3(0.0f)) && (!camera.locked)) || (drawn.size() <= 0))
+		{
+			// Get a delay based on how fast the camera is moving so that the LOD doesn't change too quickly
+			float delay = glm::length(camera.velocity) * 1.0f;
+
+			if (camera.lastUpdateTime.time_since_epoch() > std::chrono::milliseconds((int)(delay * 1000.0f)))
+			{
+				for (auto &list : workerDrawn)
+				{
+					list.clear();
+				}
+				visited.reset(visibleNodes);
+
+				// int startingLoD = (desiredLOD >= MAX_LOD - 1) ? MAX_LOD : desiredLOD + 1;
+
+				backfaceCulled = 0;
+
+				// The root(s) of the DAG is(are) the MAX_LOD meshlets, every visible instance starts from those of its mesh
+				const lod::Graph::DAG &dag = world.DAG;
+				std::vector<uint32_t> roots(dag.levelSize(MAX_LOD));
+				std::iota(roots.begin(), roots.end(), dag.levelBegin[MAX_LOD]);
+				for (uint32_t instance : visibleInstances)
+				{
+					const uint32_t mesh = world.instances[instance].mesh;
+					const uint32_t first = dag.meshLevelFirst(mesh, MAX_LOD);
+					enqueueNodes(instance, 0, roots.data() + (first - dag.levelBegin[MAX_LOD]), dag.meshLevelEnd(mesh, MAX_LOD) - first, false, &camera);
+				}
+
+				threadPool.wait();
+
+				// Ids are numbered per LoD in meshlet order, sorting keeps sequential meshlets of an instance next to each other for the coalescing below
+				drawn.clear();
+				for (auto &list : workerDrawn)
+				{
+					drawn.insert(drawn.end(), list.begin(), list.end());
+				}
+				std::sort(drawn.begin(), drawn.end());
+
+				cullOccluded(&camera);
+
+				// Other possible concurrency Depth/Breadth First search
+				// std::vector<std::thread> threads;
+				// std::queue<lod::Graph::Node> currentLevel;
+				// // This is the entire DAG
+				// while (!currentLevel.empty())
+				// {
+				// 	std::queue<lod::Graph::Node> nextLevel;
+
+				// 	// This is the local breadth of the DAG
+				// 	while (!currentLevel.empty())
+				// 	{
+				// 		lod::Graph::Node node = currentLevel.front();
+				// 		currentLevel.pop();
+
+				// 		// processNode(node, desiredLOD, nextLevel);
+				// 		// std::thread th = std::thread([node, desiredLOD, &nextLevel]()
+				// 		// 							 { processNode(node, desiredLOD, nextLevel); });
+				// 		// threads.push_back(std::move(th));
+				// 	}
+
+				// 	synchTs(threads);
+				// 	currentLevel = nextLevel;
+				// }
+
+				camera.lastUpdateTime = std::chrono::steady_clock::now();
+			}
+		}
+
+
+		selection.visible = visibleInstances;
+		selection.backfaceCulled = backfaceCulled;
+		selection.occlusionCulled = occlusionCulled;
+		selection.lastUpdateTime = camera.lastUpdateTime;
+
+		const lod::Graph::DAG &dag = world.DAG;
+
+		// Pack the selected meshlets into range keys to check which are part of the same LoD mesh so that they can be coalesced into one draw call
+		rangeKeys.clear();
+		rangeNodes.clear();
+
+		int test = 0;
+		int timesChanged = 0;
+		for (uint64_t key : drawn)
+		{
+			uint32_t node = lod::drawnNode(key);
+			rangeKeys.push_back(lod::rangeKey(lod::drawnInstance(key), dag.lods[node], dag.meshletIndices[node]));
+			rangeNodes.push_back(node);
+
+			if (test != dag.lods[node])
+			{
+				test = dag.lods[node];
+				timesChanged++;
+			}
+		}
+
+		selection.singleLOD = (timesChanged == 1) ? test : -1;
+		if (selection.singleLOD == -1)
+		{
+			lod::sortRanges(rangeKeys, rangeNodes, rangeScratch, threadPool);
+		}
+
+		// The buffers of the selection drawn before are filled the next time
+		rangeKeys.swap(selection.keys);
+		rangeNodes.swap(selection.nodes);
+
+		selection.selectMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - selection.sampled).count();
+	}
+
 	void VKRenderContext::Render()
 	{
 
@@ -394,6 +1087,9 @@ namespace jsvk
 			resources->hotReloadPipeline();
 			m_pRenderer->deinit();
 			m_pRenderer->init(m_pVulkanDevice, resources);
+
+			// The recorded buffers bind the old pipelines
+			m_recordings.clear();
 		}
 
 		uint32_t imageIndex;
@@ -402,7 +1098,7 @@ namespace jsvk
 		// VK_CHECK(acquireNextImage(&imageIndex));
 
 		// VkCommandBuffer primaryBuffer = getTempBuffer();
-		m_pRenderer->updateUniforms();
+		m_pRenderer->updateUniforms(imageIndex);
 
 		VkCommandBuffer primaryBuffer = getPrimaryBuffer();
 
@@ -429,6 +1125,20 @@ namespace jsvk
 
 		std::vector<VkCommandBuffer> secondaryBuffers;
 
+		// A range goes to the recording threads and only without them into a command buffer of its own
+		auto drawRange = [&](GameObject &object, GameObject &objectOffset, int gameObjectOffset)
+		{
+			jsvk::DynamicDraw draw;
+			if (ThreadedRecording && m_pRenderer->dynamicDraw(&object, &objectOffset, gameObjectOffset, draw))
+			{
+				m_dynamicDraws.push_back(draw);
+				return;
+			}
+
+			m_pRenderer->drawDynamic(&object, imageIndex, &primaryBuffer, inheritInfo, &objectOffset, gameObjectOffset);
+			secondaryBuffers.push_back((object.m_commandBuffers[imageIndex]));
+		};
+
 		if (camera.lastPrintTime.time_since_epoch() > 500ms)
 		{
 			float distance = glm::distance(camera.position, world.center);
@@ -454,7 +1164,7 @@ namespace jsvk
 				desiredLOD = 0;
 			}
 
-			printf("SPE: %s \t distance: %f \t lod %i \r", !DistanceThresholds ? "true" : "fals", distance, desiredLOD);
+			printf("SPE: %s \t distance: %f \t lod %i \r", !camera.distanceThresholds ? "true" : "fals", distance, desiredLOD);
 			camera.lastPrintTime = std::chrono::steady_clock::now();
 
 			desiredLOD = camera.lockedLOD;
@@ -466,191 +1176,103 @@ namespace jsvk
 		MESHLETS_DRAWN = 0;
 		NO_TRIANGLES = 0;
 
+		// The selection thread owns the selection state until it is done
+		m_selectionThread.wait();
+		applyInstanceMoves();
+
+		const std::vector<uint32_t> *discreteInstances = &visibleInstances; // The instances the discrete LoD draws
+
 		// LoD is unlocked when lockedLOD is -1
-		if (camera.lockedLOD == -1)
+		if ((camera.lockedLOD == -1) && (!camera.discrete))
 		{
-
-			if (camera.discrete)
+			if (camera.pipelinedSelection && selectionPending)
 			{
-				goto discrete;
+				frontSelection ^= 1;
 			}
-
-			if (((camera.velocity != glm::vec3(0.0f)) && (!camera.locked)) || (drawn.size() <= 0))
+			else
 			{
-				// Get a delay based on how fast the camera is moving so that the LOD doesn't change too quickly
-				float delay = glm::length(camera.velocity) * 1.0f;
-
-				if (camera.lastUpdateTime.time_since_epoch() > std::chrono::milliseconds((int)(delay * 1000.0f)))
-				{
-					mtx.lock();
-					drawn = {};
-					visited = {};
-					mtx.unlock();
-
-					// This is the optimal number of threads that should be competing for jobs
-					threadPool.restart(12);
-
-					// int startingLoD = (desiredLOD >= MAX_LOD - 1) ? MAX_LOD : desiredLOD + 1;
-
-					// The root(s) of the DAG is(are) the MAX_LOD meshlets
-					for (int i = 0; i < world.DAG.nodes[MAX_LOD].size(); i++)
-					{
-						lod::Graph::Node *root = &world.DAG.nodes[MAX_LOD][i];
-
-						mtx.lock();
-						visited.insert(root->id);
-						mtx.unlock();
-
-						if (DistanceThresholds)
-						{
-							threadPool.enqueue([=]()
-											   { processNode_distance(root, &camera); });
-						}
-						else
-						{
-							threadPool.enqueue([=]()
-											   { processNode_SSE(root, &camera); });
-						}
-					}
-
-					threadPool.stopAndJoin();
-
-					// Other possible concurrency Depth/Breadth First search
-					// std::vector<std::thread> threads;
-					// std::queue<lod::Graph::Node> currentLevel;
-					// // This is the entire DAG
-					// while (!currentLevel.empty())
-					// {
-					// 	std::queue<lod::Graph::Node> nextLevel;
-
-					// 	// This is the local breadth of the DAG
-					// 	while (!currentLevel.empty())
-					// 	{
-					// 		lod::Graph::Node node = currentLevel.front();
-					// 		currentLevel.pop();
-
-					// 		// processNode(node, desiredLOD, nextLevel);
-					// 		// std::thread th = std::thread([node, desiredLOD, &nextLevel]()
-					// 		// 							 { processNode(node, desiredLOD, nextLevel); });
-					// 		// threads.push_back(std::move(th));
-					// 	}
-
-					// 	synchTs(threads);
-					// 	currentLevel = nextLevel;
-					// }
-
-					camera.lastUpdateTime = std::chrono::steady_clock::now();
-				}
+				selectLOD(camera, selections[frontSelection]);
 			}
+			selectionPending = false;
 
-			int rp = 0; // This is to pick a render pool
-			// Sort the drawn vector based on increasing meshletIndex so that more meshlet are packed into a single draw call?
-			// std::sort(drawn.begin(), drawn.end(), [](lod::Graph::Node *a, lod::Graph::Node *b)
-			// 		  { return a->meshletIndex < b->meshletIndex; });
+			Selection &current = selections[frontSelection];
 
-			std::vector<std::unordered_map<int, std::queue<lod::Graph::Node *>>> mesh_node_heirarchy(world.mesh_paths.size()); // Maps the nodes that have been selected to be drawn into their respective LoD and render pool
+			BACKFACE_CULLED = current.backfaceCulled;
+			OCCLUSION_CULLED = current.occlusionCulled;
+			SELECTION_TIME = current.selectMs;
+			SELECTION_LATENCY = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - current.sampled).count();
+			camera.lastUpdateTime = current.lastUpdateTime;
 
-			// loop through the selected meshlets to check which are part of the same LoD mesh so that they can be coalesced into one draw call
-			int test = 0;
-			int timesChanged = 0;
-			for (auto &node : drawn)
+			// The next frame is selected while this one is recorded and drawn, from where the camera will be by then and
+			// looking where it will look. The copy also holds the culling and threshold toggles, so a key pressed while
+			// the thread runs only changes the selection after it
+			if (camera.pipelinedSelection)
 			{
-				mesh_node_heirarchy[node->meshIndex][node->lod].emplace(node);
+				lod::Camera predicted = lod::predictCamera(camera, camera.frameTime.smoothedMs);
 
-				if (test != node->lod)
-				{
-					test = node->lod;
-					timesChanged++;
-				}
+				Selection *next = &selections[frontSelection ^ 1];
+				m_selectionThread.queuejob([predicted, next]() mutable
+										   { selectLOD(predicted, *next); });
+				selectionPending = true;
 			}
 
-			if (timesChanged == 1)
+			if (current.singleLOD != -1)
 			{
-				desiredLOD = test;
+				desiredLOD = current.singleLOD;
 				traversed = true;
+				discreteInstances = &current.visible;
 				goto discrete;
 			}
 
-			for (int i = 0; i < world.mesh_paths.size(); i++)
+			int rp = 0; // This is to pick a render pool
+
+			const lod::Graph::DAG &dag = world.DAG;
+
+			// Draw every maximal run of sequential meshlets of an instance and LoD in a single draw call, duplicates are skipped
+			for (size_t first = 0; first < current.keys.size();)
 			{
-				std::unordered_map<int, std::queue<lod::Graph::Node *>> &node_heirarchy = mesh_node_heirarchy[i]; // Maps the nodes that have been selected to be drawn into their respective LoD
+				int noMeshlets = 1; // This is the number of meshlets that will be drawn in a single draw call
+				NO_TRIANGLES += dag.triangleCounts[current.nodes[first]];
 
-				for (auto &[lod, nodes] : node_heirarchy)
+				size_t next = first + 1;
+				for (; next < current.keys.size(); next++)
 				{
-					int noMeshlets = 0;			   // This is the number of meshlets that will be drawn in a single draw call
-					int previousMeshletIndex = -1; // This is to check if the meshlets are sequential
-					bool drawCallFinalized = false;
-
-					// Draw sequential meshlets in a single draw call
-					do
+					if (current.keys[next] == current.keys[next - 1])
 					{
-						if (previousMeshletIndex == -1)
-						{
-							previousMeshletIndex = nodes.front()->meshletIndex;
-							camera.start = nodes.front()->meshletIndex; // Where the first meshlet in the draw call starts
-							NO_TRIANGLES += nodes.front()->no_triangles;
-							noMeshlets++;
-							nodes.pop();
-						}
-						else if (previousMeshletIndex != (nodes.front()->meshletIndex - 1))
-						{
-							drawCallFinalized = true;
-						}
-						else if (previousMeshletIndex == nodes.front()->meshletIndex)
-						{
-							// This is a duplicate meshlet so just skip it
-							nodes.pop();
-						}
-						else
-						{
-							// This is a sequential meshlet so just add it to the draw call
-							previousMeshletIndex = nodes.front()->meshletIndex;
-							noMeshlets++;
-							NO_TRIANGLES += nodes.front()->no_triangles;
-							nodes.pop();
-						}
+						continue;
+					}
 
-						if ((drawCallFinalized) || (nodes.empty()))
-						{
-							// This is a cheat so that the DAG doesn't need to be traversed for multiple copies of the same object, but is not the correct way of doing it.
-							// for (int i = 0; i < world.mesh_paths.size(); i++)
-							{
-								camera.offset = lod;	 // The start of the LoD indices and vertices
-								camera.end = noMeshlets; // How many meshlets to draw
+					// The next meshlet index of the same instance and LoD is the next key
+					if (current.keys[next] != current.keys[next - 1] + 1)
+					{
+						break;
+					}
 
-								if (rp < world.gameObjects.size())
-								{
-									GameObject &object = world.gameObjects[rp];
+					noMeshlets++;
+					NO_TRIANGLES += dag.triangleCounts[current.nodes[next]];
+				}
 
-									GameObject &objectOffset = resources->scene.gameObjects[i]; // This works for discrete but not for CLoD so we need to send it it as an offset object
+				const uint32_t i = lod::rangeInstance(current.keys[first]);
 
-									m_pRenderer->drawDynamic(&object, imageIndex, &primaryBuffer, inheritInfo, &objectOffset, i);
-									secondaryBuffers.push_back((object.m_commandBuffers[imageIndex]));
+				camera.start = lod::rangeMeshlet(current.keys[first]); // Where the first meshlet in the draw call starts
+				camera.offset = lod::rangeLOD(current.keys[first]);	  // The start of the LoD indices and vertices
+				camera.end = noMeshlets;						  // How many meshlets to draw
 
-									DRAW_CALLS++;
+				GameObject &object = world.gameObjects[rp];
 
-									rp += noMeshlets;
+				GameObject &objectOffset = resources->scene.gameObjects[i]; // The object of the instance, it holds the world matrix
 
-									// We cannot draw more meshlets than there are allocated command buffer pools
-									if (rp >= world.gameObjects.size())
-									{
-										break;
-									}
-								}
-							}
+				drawRange(object, objectOffset, world.instances[i].mesh);
 
-							noMeshlets = 0;
-							drawCallFinalized = false;
-							previousMeshletIndex = -1;
-						}
+				DRAW_CALLS++;
 
-						// We cannot draw more meshlets than there are allocated command buffer pools
-						if (rp >= world.gameObjects.size())
-						{
-							break;
-						}
+				rp += noMeshlets;
+				first = next;
 
-					} while (!nodes.empty());
+				// We cannot draw more meshlets than there are allocated command buffer pools
+				if (rp >= world.gameObjects.size())
+				{
+					break;
 				}
 			}
 
@@ -663,7 +1285,17 @@ namespace jsvk
 			// Discrete LoD does not blend LoDs into one model!
 		discrete:
 
-			for (int i = 0; i < world.mesh_paths.size(); i++)
+			if ((camera.lockedLOD != -1) || (camera.discrete))
+			{
+				// A selection made before the LoD was locked is not drawn anymore
+				selectionPending = false;
+
+				frustumPlanes = lod::FrustumPlanes(camera.frustum);
+				selectInstances(&camera);
+			}
+
+			// Whole instances outside the frustum or too far away were already dropped by selectInstances
+			for (uint32_t i : *discreteInstances)
 			{
 				GameObject &object = resources->scene.gameObjects[i];
 
@@ -700,15 +1332,14 @@ namespace jsvk
 					desiredLOD = 0;
 				}
 
-				int offset = i * (MAX_LOD + 1);
+				int offset = world.instances[i].mesh * (MAX_LOD + 1);
 				int noMeshlets = world.model.desc_counts[desiredLOD + offset];
 
 				camera.start = -1;			// Where to start drawing
 				camera.offset = desiredLOD; // What offset to use in the model vertices
 				camera.end = noMeshlets;	// How many meshlets to draw
 
-				m_pRenderer->drawDynamic(&object, imageIndex, &primaryBuffer, inheritInfo, &object, i);
-				secondaryBuffers.push_back((object.m_commandBuffers[imageIndex]));
+				drawRange(object, object, world.instances[i].mesh);
 
 				NO_TRIANGLES += world.model.no_triangles[desiredLOD + offset];
 				MESHLETS_DRAWN += noMeshlets;
@@ -716,6 +1347,12 @@ namespace jsvk
 			}
 		}
 
+		auto recordStart = std::chrono::steady_clock::now();
+
+		recordDynamic(imageIndex, inheritInfo, secondaryBuffers);
+
+		RECORD_TIME = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - recordStart).count();
+
 		if (MESHLETS_DRAWN != 0)
 		{
 			vkCmdExecuteCommands(primaryBuffer, secondaryBuffers.size(), secondaryBuffers.data());
@@ -732,6 +1369,121 @@ namespace jsvk
 		// VK_CHECK(presentImage(primaryBuffer, &imageIndex));
 	}
 
+	void VKRenderContext::recordDynamic(uint32_t imageIndex, VkCommandBufferInheritanceInfo &inheritInfo, std::vector<VkCommandBuffer> &secondaryBuffers)
+	{
+		if (m_dynamicDraws.empty())
+		{
+			return;
+		}
+
+		if (m_recordThreads.threads.empty())
+		{
+			m_recordThreads.setThreadCount(std::max(std::thread::hardware_concurrency(), 1u));
+		}
+
+		if (m_threadData.size() <= imageIndex)
+		{
+			m_threadData.resize(imageIndex + 1);
+		}
+
+		if (m_recordings.size() <= imageIndex)
+		{
+			m_recordings.resize(imageIndex + 1);
+		}
+
+		std::vector<threadData> &frameData = m_threadData[imageIndex];
+
+		// FNV-1a over everything the buffers are recorded from, a still camera selects the same draws every frame
+		uint64_t hash = 14695981039346656037ull;
+		auto hashValue = [&hash](const auto &value)
+		{
+			const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&value);
+			for (size_t i = 0; i < sizeof(value); ++i)
+			{
+				hash ^= bytes[i];
+				hash *= 1099511628211ull;
+			}
+		};
+
+		hashValue(CURRENTPIPE);
+		hashValue(inheritInfo.framebuffer);
+		for (const jsvk::DynamicDraw &draw : m_dynamicDraws)
+		{
+			hashValue(draw.range);
+			hashValue(draw.mesh->pipelineID);
+			hashValue(draw.mesh->ObjectOffset);
+			hashValue(draw.offsetMesh->ObjectOffset);
+		}
+
+		// The buffers are not recorded for simultaneous use, executing them again is only valid because acquireNextImage
+		// waited for the frame that last executed them
+		Recording &recorded = m_recordings[imageIndex];
+		if (ReuseRecording && (recorded.hash == hash) && (recorded.threads != 0))
+		{
+			for (uint32_t t = 0; t < recorded.threads; t++)
+			{
+				secondaryBuffers.push_back(frameData[t].cmdBuffer);
+			}
+
+			m_dynamicDraws.clear();
+			return;
+		}
+		while (frameData.size() < m_recordThreads.threads.size())
+		{
+			threadData data;
+			data.cmdPool = m_pVulkanDevice->createCommandPool(m_pVulkanDevice->m_queueFamilyIndices.graphics, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+
+			VkCommandBufferAllocateInfo allocInfo = jsvk::init::commandBufferAllocateInfo();
+			allocInfo.commandPool = data.cmdPool;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandBufferCount = 1;
+
+			VK_CHECK(vkAllocateCommandBuffers(m_pVulkanDevice->Device(), &allocInfo, &data.cmdBuffer));
+
+			frameData.push_back(data);
+		}
+
+		// A thread only gets a batch when there are enough draws to make up for waking it up
+		const uint32_t RECORD_BATCH = 64;
+		const uint32_t count = uint32_t(m_dynamicDraws.size());
+		const uint32_t threads = std::min(uint32_t(frameData.size()), (count + RECORD_BATCH - 1) / RECORD_BATCH);
+		const uint32_t batch = (count + threads - 1) / threads;
+
+		for (uint32_t t = 0; t < threads; t++)
+		{
+			m_recordThreads.threads[t]->queuejob([this, &frameData, &inheritInfo, imageIndex, t, batch, count]()
+												  {
+				const threadData &data = frameData[t];
+
+				// acquireNextImage waited for the frame that last drew into this image, its buffers are done on the GPU
+				vkResetCommandPool(m_pVulkanDevice->Device(), data.cmdPool, 0);
+
+				VkCommandBufferBeginInfo beginInfo = jsvk::init::commandBufferBeginInfo();
+				beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+				beginInfo.pInheritanceInfo = &inheritInfo;
+
+				uint32_t first = std::min(t * batch, count);
+				uint32_t last = std::min(first + batch, count);
+
+				vkBeginCommandBuffer(data.cmdBuffer, &beginInfo);
+				m_pRenderer->recordDynamic(data.cmdBuffer, imageIndex, m_dynamicDraws.data() + first, last - first);
+				vkEndCommandBuffer(data.cmdBuffer); });
+		}
+
+		m_recordThreads.wait();
+
+		// In thread order so the draws are executed in the order they were taken
+		for (uint32_t t = 0; t < threads; t++)
+		{
+			secondaryBuffers.push_back(frameData[t].cmdBuffer);
+		}
+
+		recorded.hash = hash;
+		recorded.threads = threads;
+
+		m_dynamicDraws.clear();
+	}
+
 	VkResult VKRenderContext::acquireNextImage(uint32_t *imageIndex)
 	{
 		VkResult res = VK_SUCCESS;
@@ -741,6 +1493,18 @@ namespace jsvk
 		res = m_pSwapchain->acquireNextImage(frame->m_imageAvailableSemaphore, imageIndex);
 
 		vkWaitForFences(m_pVulkanDevice->Device(), 1, &frame->m_inFlightFence, VK_TRUE, UINT64_MAX);
+
+		// The command pools and buffers of the image are only reset or executed again once the frame that drew into it is done
+		if (m_imagesInFlight.size() <= *imageIndex)
+		{
+			m_imagesInFlight.resize(*imageIndex + 1, VK_NULL_HANDLE);
+		}
+		if ((m_imagesInFlight[*imageIndex] != VK_NULL_HANDLE) && (m_imagesInFlight[*imageIndex] != frame->m_inFlightFence))
+		{
+			vkWaitForFences(m_pVulkanDevice->Device(), 1, &m_imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
+		}
+		m_imagesInFlight[*imageIndex] = frame->m_inFlightFence;
+
 		vkResetFences(m_pVulkanDevice->Device(), 1, &frame->m_inFlightFence);
 
 		// frame->reset();
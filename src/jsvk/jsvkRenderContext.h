@@ -6,6 +6,7 @@
 #include "jsvkSwapchain.h"
 #include "jsvkRenderFrame.h"
 #include "jsvkRenderer.h"
+#include "jsvkThreadpool.hpp"
 
 #include "lodGeometry.hpp"
 
@@ -59,6 +60,10 @@ namespace jsvk
 		uint32_t m_currentFrame;
 		const int m_MAX_FRAMES_IN_FLIGHT = 2;
 
+		// The fence of the frame that last drew into every swapchain image. The images are not acquired in the order of
+		// the frames in flight, so acquireNextImage also waits for this fence before anything of the image is reused
+		std::vector<VkFence> m_imagesInFlight;
+
 		// constructor
 		VKRenderContext(jsk::Presenter *presenter, jsvk::VulkanDevice *pDevice);
 		// destructor
@@ -69,6 +74,30 @@ namespace jsvk
 		VkCommandBuffer getTempBuffer() override;
 		VkCommandBuffer getPrimaryBuffer();
 		void Render() override;
+
+	private:
+		jsvk::Thread m_selectionThread; // Selects the LoD of the next frame while the current one is drawn
+
+		// Threaded recording
+		// The draws are split into batches in draw order, every recording thread records
+		// its batch into the secondary command buffer of its own pool for the swapchain image, the pool is reset instead
+		// of freeing buffers
+		jsvk::ThreadPool m_recordThreads;
+		std::vector<std::vector<threadData>> m_threadData; // The pool and buffer of every recording thread for every swapchain image
+		std::vector<jsvk::DynamicDraw> m_dynamicDraws;	   // Taken during the selection, recorded by recordDynamic
+
+		// The hash of the draws and the pipeline the buffers of every swapchain image were recorded with, and how many of
+		// the buffers hold a batch. The buffers are executed again as they are while the hash stays the same, once the
+		// fence of the image in m_imagesInFlight says the frame that last executed them is done
+		struct Recording
+		{
+			uint64_t hash = 0;
+			uint32_t threads = 0;
+		};
+		std::vector<Recording> m_recordings;
+
+		// Records m_dynamicDraws and appends one secondary command buffer per thread that recorded a batch
+		void recordDynamic(uint32_t imageIndex, VkCommandBufferInheritanceInfo &inheritInfo, std::vector<VkCommandBuffer> &secondaryBuffers);
 	};
 }
 
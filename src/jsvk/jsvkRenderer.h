@@ -9,6 +9,14 @@
 
 namespace jsvk
 {
+	// A draw of drawDynamic with its range already taken from the camera, so that it can be recorded on any thread
+	struct DynamicDraw
+	{
+		GameObject *mesh;
+		GameObject *offsetMesh; // The object of the instance, it holds the world matrix
+		DrawRange range;
+	};
+
 	class Renderer
 	{
 	public:
@@ -37,9 +45,18 @@ namespace jsvk
 		virtual bool init(jsvk::VulkanDevice *pVulkanDevice, jsvk::Resources *pResources) = 0;
 		virtual void deinit() = 0;
 		virtual void draw(uint32_t imageIndex, VkCommandBuffer *primaryBuffer) = 0;
-		virtual void updateUniforms() = 0;
+		// Writes the uniform data of the frame that draws into the swapchain image
+		virtual void updateUniforms(uint32_t imageIndex) = 0;
 		virtual void drawDynamic(GameObject *mesh, uint32_t imageIndex, VkCommandBuffer *primaryBuffer, VkCommandBufferInheritanceInfo &inheritInfo, GameObject *offsetMesh, int gameObjectOffset) = 0;
 
+		// Takes the draw drawDynamic would record with the current camera, false when the renderer can only record with
+		// drawDynamic
+		virtual bool dynamicDraw(GameObject *mesh, GameObject *offsetMesh, int gameObjectOffset, DynamicDraw &draw) { return false; }
+
+		// Records the draws of the swapchain image into a secondary command buffer that is already begun, nothing global
+		// is written so several threads can record into their own command buffers at once
+		virtual void recordDynamic(VkCommandBuffer cmdBuffer, uint32_t imageIndex, const DynamicDraw *draws, uint32_t count) {}
+
 		virtual ~Renderer() {}
 	};
 
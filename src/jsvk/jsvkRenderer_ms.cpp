@@ -43,8 +43,10 @@ namespace jsvk
 		bool init(jsvk::VulkanDevice *m_pVulkanDevice, jsvk::Resources *pResources) override;
 		void deinit() override;
 		void draw(uint32_t imageIndex, VkCommandBuffer *primaryBuffer) override;
-		void updateUniforms() override;
+		void updateUniforms(uint32_t imageIndex) override;
 		void drawDynamic(GameObject *mesh, uint32_t imageIndex, VkCommandBuffer *primaryBuffer, VkCommandBufferInheritanceInfo &inheritInfo, GameObject *offsetMesh, int gameObjectOffset) override;
+		bool dynamicDraw(GameObject *mesh, GameObject *offsetMesh, int gameObjectOffset, DynamicDraw &draw) override;
+		void recordDynamic(VkCommandBuffer cmdBuffer, uint32_t imageIndex, const DynamicDraw *draws, uint32_t count) override;
 		jsvk::ResourcesMS *getResources() { return m_pResources; }
 
 		MeshRenderer()
@@ -58,6 +60,8 @@ namespace jsvk
 		jsvk::ResourcesMS *m_pResources;
 		bool first = true;
 
+		DrawRange drawRange(GameObject *mesh, GameObject *offsetMesh, int gameObjectOffset);
+
 		void createCommmandBuffers()
 		{
 
@@ -112,11 +116,12 @@ namespace jsvk
 
 							if (first)
 							{
-								// here I changed i to (i % 2) because i should be used as 0 or 1 but the swapchain has 3 images
-								uint32_t view_offset = 0;
+								// The buffers of swapchain image k read its region
+								uint32_t region_offset = m_pResources->regionOffset(k);
+								uint32_t view_offsets[2] = {region_offset, region_offset};
 
 								vkCmdBindDescriptorSets(m_commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, m_pResources->m_meshShaderPipelineLayouts[1], 0,
-														1, m_pResources->sceneSets.data(), 1, &view_offset);
+														1, m_pResources->sceneSets.data(), 2, view_offsets);
 
 								vkCmdBindDescriptorSets(m_commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, m_pResources->m_meshShaderPipelineLayouts[1], 2,
 														1, m_pResources->geoSets.data(), 0, nullptr);
@@ -133,7 +138,7 @@ namespace jsvk
 						}
 						// for each mesh draw!
 
-						uint32_t obj_offset = j * sizeof(ObjectData);
+						uint32_t obj_offset = m_pResources->regionOffset(k) + j * sizeof(ObjectData);
 						vkCmdBindDescriptorSets(m_commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, m_pResources->m_meshShaderPipelineLayouts[1], 1,
 												1, m_pResources->objSets.data(), 1, &obj_offset);
 
@@ -141,9 +146,9 @@ namespace jsvk
 						// assert(uint32_t(geo.vbo.offset / vertexSize) == uint32_t(geo.abo.offset / vertexAttributeSize));
 
 						uint32_t offsets[4] = {uint32_t(m_pResources->m_geos[j].desc_offset / sizeof(NVMeshlet::MeshletDesc)),
-											   uint32_t(m_pResources->m_geos[j].prim_offset / (NVMeshlet::PRIMITIVE_INDICES_PER_FETCH)),
+											   uint32_t(m_pResources->m_geos[j].prim_offset / (mm::PRIM_FETCH_SIZE)),
 											   uint32_t(m_pResources->m_geos[j].vert_offset / (m_pResources->m_geos[j].shorts == 1 ? 2 : 4)),
-											   uint32_t(m_pResources->m_geos[j].vbo_offset / (3 * sizeof(float)))};
+											   uint32_t(m_pResources->m_geos[j].vbo_offset / mm::VBO_VERTEX_STRIDE)};
 
 						vkCmdPushConstants(m_commandBuffers[i], m_pResources->m_meshShaderPipelineLayouts[1],
 										   VK_SHADER_STAGE_TASK_BIT_NV | VK_SHADER_STAGE_MESH_BIT_NV, 0, sizeof(offsets), offsets);
@@ -211,7 +216,7 @@ namespace jsvk
 		}
 	}
 
-	void MeshRenderer::updateUniforms()
+	void MeshRenderer::updateUniforms(uint32_t imageIndex)
 	{
 #if CONTINUOUSROTATION
 		static auto startTime = std::chrono::high_resolution_clock::now();
@@ -235,24 +240,25 @@ namespace jsvk
 		m_pResources->m_sceneData[0].viewPos = viewI[3]; // glm::vec4(0.0f, 0.0f, -5.0f, 1.0f); //  //glm::vec4(0.0f, 0.0f, -5.0f, 1.0f);
 		m_pResources->m_sceneData[0].viewDir = -view[2];
 
-		char *uniformChar = (char *)m_pResources->m_uniformBuffer.m_mapped;
+		char *uniformChar = m_pResources->updateRegion(imageIndex);
 		//}
 
 		// check out vulkan memcpy for this
 #if STATS
-		memcpy(m_pResources->m_cullStats, &uniformChar[2 * m_pResources->m_dynamicAlignment], sizeof(CullStats));
+		// The stats of the last frame that drew into this image
+		memcpy(m_pResources->m_cullStats, &uniformChar[m_pResources->m_statsOffset], sizeof(CullStats));
 		// print shit
 		std::cout << "Number of meshlets actually drawn: " << m_pResources->m_cullStats->meshletsOutput << "."
 				  << "\r";
 		m_pResources->m_cullStats->meshletsOutput = 0;
 		m_pResources->m_cullStats->tasksOutput = 0;
-		memcpy(&uniformChar[2 * m_pResources->m_dynamicAlignment], m_pResources->m_cullStats, sizeof(CullStats));
+		memcpy(&uniformChar[m_pResources->m_statsOffset], m_pResources->m_cullStats, sizeof(CullStats));
 #endif
-		memcpy(&uniformChar[0], &m_pResources->m_sceneData[0], sizeof(SceneData));
 		// first = -1;
 	}
 
-	void MeshRenderer::drawDynamic(GameObject *mesh, uint32_t imageIndex, VkCommandBuffer *primaryBuffer, VkCommandBufferInheritanceInfo &inheritInfo, GameObject *offsetMesh, int gameObjectOffset)
+	// The offsets of camera.end meshlets from camera.start in LoD camera.offset of the mesh, shared by drawDynamic and the threaded recording
+	DrawRange MeshRenderer::drawRange(GameObject *mesh, GameObject *offsetMesh, int gameObjectOffset)
 	{
 		int desiredLOD = camera.offset;
 
@@ -265,6 +271,37 @@ namespace jsvk
 			desiredLOD = 0;
 		}
 
+		DrawRange range;
+
+		int offset = gameObjectOffset * (MAX_LOD + 1);
+
+		// Camera.start being -1 means discrete LoD and therefore the entire model can be drawn in a single draw call
+		if (camera.start == -1)
+		{
+			range.geometryOffsets.x = uint32_t((((world.model.desc_offsets[desiredLOD + offset])) + (0 * sizeof(NVMeshlet::MeshletDesc))) / sizeof(NVMeshlet::MeshletDesc));
+		}
+		else
+		{
+			range.geometryOffsets.x = uint32_t((((world.model.desc_offsets[desiredLOD + offset])) + (camera.start * sizeof(NVMeshlet::MeshletDesc))) / sizeof(NVMeshlet::MeshletDesc));
+		}
+
+		range.geometryOffsets.y = uint32_t((((world.model.prim_offsets[desiredLOD + offset])) + (0 * sizeof(NVMeshlet::PrimitiveIndexType))) / (mm::PRIM_FETCH_SIZE));
+		range.geometryOffsets.z = uint32_t((((world.model.vert_offsets[desiredLOD + offset])) + (0 * sizeof(uint32_t))) / (mesh->shorts == 1 ? 2 : 4));
+		range.geometryOffsets.w = uint32_t((((world.model.vbo_offsets[desiredLOD + offset])) + (0 * mm::VBO_VERTEX_STRIDE))) / mm::VBO_VERTEX_STRIDE;
+
+		range.assigns.x = uint32_t(offsetMesh->ObjectOffset);
+		range.assigns.y = uint32_t(camera.end - 1); // This is the thing that fucks not being able to send it in one draw call since it is telling it how many meshlets to draw at this offset
+		range.assigns.z = desiredLOD;
+		range.assigns.w = (camera.start == -1) ? 0 : camera.start;
+
+		return range;
+	}
+
+	void MeshRenderer::drawDynamic(GameObject *mesh, uint32_t imageIndex, VkCommandBuffer *primaryBuffer, VkCommandBufferInheritanceInfo &inheritInfo, GameObject *offsetMesh, int gameObjectOffset)
+	{
+		DynamicDraw draw;
+		dynamicDraw(mesh, offsetMesh, gameObjectOffset, draw);
+
 		VkCommandBufferBeginInfo beginInfo = jsvk::init::commandBufferBeginInfo();
 		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
 		beginInfo.pInheritanceInfo = &inheritInfo; // Optional
@@ -274,76 +311,74 @@ namespace jsvk
 		vkBeginCommandBuffer(secCmdBuffer, &beginInfo);
 		// VK_CHECK(vkBeginCommandBuffer(secCmdBuffer, &beginInfo));
 
-		// I need to know the current pipelines
-		int pipeID = mesh->pipelineID == 1 ? 1 : 0;
-		vkCmdBindPipeline(secCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pResources->m_meshShaderPipelines[CURRENTPIPE]);
+		recordDynamic(secCmdBuffer, imageIndex, &draw, 1);
 
-		// here I changed i to (i % 2) because i should be used as 0 or 1 but the swapchain has 3 images
-		uint32_t view_offset = 0;
+		vkEndCommandBuffer(secCmdBuffer);
 
-		vkCmdBindDescriptorSets(secCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pResources->m_meshShaderPipelineLayouts[1], 0,
-								1, m_pResources->sceneSets.data(), 1, &view_offset);
+		// VK_CHECK((vkEndCommandBuffer(secCmdBuffer)));
+	}
 
-		vkCmdBindDescriptorSets(secCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pResources->m_meshShaderPipelineLayouts[1], 2,
-								1, m_pResources->geoSets.data(), 0, nullptr);
+	bool MeshRenderer::dynamicDraw(GameObject *mesh, GameObject *offsetMesh, int gameObjectOffset, DynamicDraw &draw)
+	{
+		draw.mesh = mesh;
+		draw.offsetMesh = offsetMesh;
+		draw.range = drawRange(mesh, offsetMesh, gameObjectOffset);
 
-		// only add descriptor for texture when there is a texture for the object
-		if (mesh->pipelineID == 1)
-		{
-			vkCmdBindDescriptorSets(secCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pResources->m_meshShaderPipelineLayouts[1], 3,
-									1, &m_pResources->imgSets[mesh->ObjectOffset], 0, nullptr);
-		}
+		return true;
+	}
 
-		// for each mesh draw
-		uint32_t obj_offset = mesh->ObjectOffset * sizeof(ObjectData);
-		vkCmdBindDescriptorSets(secCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pResources->m_meshShaderPipelineLayouts[1], 1,
-								1, m_pResources->objSets.data(), 1, &obj_offset);
+	void MeshRenderer::recordDynamic(VkCommandBuffer cmdBuffer, uint32_t imageIndex, const DynamicDraw *draws, uint32_t count)
+	{
+		// I need to know the current pipelines
+		vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pResources->m_meshShaderPipelines[CURRENTPIPE]);
 
-		// we use the same vertex offset for both vbo and abo, our allocator should ensure this condition.
-		// assert(uint32_t(geo.vbo.offset / vertexSize) == uint32_t(geo.abo.offset / vertexAttributeSize));
+		// The scene, the stats and the objects of the region of the image
+		uint32_t region_offset = m_pResources->regionOffset(imageIndex);
+		uint32_t view_offsets[2] = {region_offset, region_offset};
 
-		uint32_t offsets[4];
+		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pResources->m_meshShaderPipelineLayouts[1], 0,
+								1, m_pResources->sceneSets.data(), 2, view_offsets);
 
-		int offset = gameObjectOffset * (MAX_LOD + 1);
+		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pResources->m_meshShaderPipelineLayouts[1], 2,
+								1, m_pResources->geoSets.data(), 0, nullptr);
 
-		// Camera.start being -1 means discrete LoD and therefore the entire model can be drawn in a single draw call
-		if (camera.start == -1)
-		{
-			offsets[0] = uint32_t((((world.model.desc_offsets[desiredLOD + offset])) + (0 * sizeof(NVMeshlet::MeshletDesc))) / sizeof(NVMeshlet::MeshletDesc));
-		}
-		else
+		for (uint32_t i = 0; i < count; i++)
 		{
-			offsets[0] = uint32_t((((world.model.desc_offsets[desiredLOD + offset])) + (camera.start * sizeof(NVMeshlet::MeshletDesc))) / sizeof(NVMeshlet::MeshletDesc));
-		}
-
-		offsets[1] = uint32_t((((world.model.prim_offsets[desiredLOD + offset])) + (0 * sizeof(NVMeshlet::PrimitiveIndexType))) / (NVMeshlet::PRIMITIVE_INDICES_PER_FETCH));
-		offsets[2] = uint32_t((((world.model.vert_offsets[desiredLOD + offset])) + (0 * sizeof(uint32_t))) / (mesh->shorts == 1 ? 2 : 4));
-		offsets[3] = uint32_t((((world.model.vbo_offsets[desiredLOD + offset])) + (0 * (3 * sizeof(float))))) / (3 * sizeof(float));
+			const DynamicDraw &draw = draws[i];
+			int desiredLOD = draw.range.assigns.z;
 
-		vkCmdPushConstants(secCmdBuffer, m_pResources->m_meshShaderPipelineLayouts[1],
-						   VK_SHADER_STAGE_TASK_BIT_NV | VK_SHADER_STAGE_MESH_BIT_NV, 0, sizeof(offsets), offsets);
+			// only add descriptor for texture when there is a texture for the object
+			if (draw.mesh->pipelineID == 1)
+			{
+				vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pResources->m_meshShaderPipelineLayouts[1], 3,
+										1, &m_pResources->imgSets[draw.mesh->ObjectOffset], 0, nullptr);
+			}
 
-		if (useTask)
-		{
-			glm::uvec4 assigns;
+			// for each mesh draw, the object of the instance being drawn holds its world matrix
+			uint32_t obj_offset = region_offset + draw.offsetMesh->ObjectOffset * sizeof(ObjectData);
+			vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pResources->m_meshShaderPipelineLayouts[1], 1,
+									1, m_pResources->objSets.data(), 1, &obj_offset);
 
-			assigns.x = 0;
-			assigns.y = uint32_t(camera.end - 1); // This is the thing that fucks not being able to send it in one draw call since it is telling it how many meshlets to draw at this offset
-			assigns.z = desiredLOD;
-			assigns.w = (camera.start == -1) ? 0 : camera.start;
+			// we use the same vertex offset for both vbo and abo, our allocator should ensure this condition.
+			// assert(uint32_t(geo.vbo.offset / vertexSize) == uint32_t(geo.abo.offset / vertexAttributeSize));
 
-			vkCmdPushConstants(secCmdBuffer, m_pResources->m_meshShaderPipelineLayouts[1], VK_SHADER_STAGE_TASK_BIT_NV,
-							   sizeof(uint32_t) * 4, sizeof(assigns), &assigns);
-		}
+			vkCmdPushConstants(cmdBuffer, m_pResources->m_meshShaderPipelineLayouts[1],
+							   VK_SHADER_STAGE_TASK_BIT_NV | VK_SHADER_STAGE_MESH_BIT_NV, 0, sizeof(draw.range.geometryOffsets), &draw.range.geometryOffsets);
 
-		// update this when we go into task shaders
-		uint32_t count = useTask == 1 ? NVMeshlet::computeTasksCount(world.model.desc_counts[desiredLOD]) : world.model.desc_counts[desiredLOD]; // ; // NVMeshlet::computeTasksCount(meshletGeometry.meshletDescriptors.size());
+			if (useTask)
+			{
+				glm::uvec4 assigns = draw.range.assigns;
+				assigns.x = 0;
 
-		vkCmdDrawMeshTasksNV(secCmdBuffer, count, 0);
+				vkCmdPushConstants(cmdBuffer, m_pResources->m_meshShaderPipelineLayouts[1], VK_SHADER_STAGE_TASK_BIT_NV,
+								   sizeof(uint32_t) * 4, sizeof(assigns), &assigns);
+			}
 
-		vkEndCommandBuffer(secCmdBuffer);
+			// update this when we go into task shaders
+			uint32_t tasks = useTask == 1 ? NVMeshlet::computeTasksCount(world.model.desc_counts[desiredLOD]) : world.model.desc_counts[desiredLOD]; // ; // NVMeshlet::computeTasksCount(meshletGeometry.meshletDescriptors.size());
 
-		// VK_CHECK((vkEndCommandBuffer(secCmdBuffer)));
+			vkCmdDrawMeshTasksNV(cmdBuffer, tasks, 0);
+		}
 	}
 
 	void MeshRenderer::draw(uint32_t imageIndex, VkCommandBuffer *primaryBuffer)
@@ -32,7 +32,7 @@ namespace jsvk
 		bool init(jsvk::VulkanDevice *m_pVulkanDevice, jsvk::Resources *pResources) override;
 		void deinit() override;
 		void draw(uint32_t imageIndex, VkCommandBuffer *primaryBuffer) override;
-		void updateUniforms() override;
+		void updateUniforms(uint32_t imageIndex) override;
 		void drawDynamic(GameObject *mesh, uint32_t imageIndex, VkCommandBuffer *primaryBuffer, VkCommandBufferInheritanceInfo &inheritInfo, GameObject *offsetMesh, int gameObjectOffset) override;
 		jsvk::ResourcesVS *getResources() { return m_pResources; }
 
@@ -171,7 +171,7 @@ namespace jsvk
 		}
 	}
 
-	void VertRenderer::updateUniforms()
+	void VertRenderer::updateUniforms(uint32_t imageIndex)
 	{
 		// static auto startTime = std::chrono::high_resolution_clock::now();
 
@@ -180,6 +180,31 @@ namespace jsvk
 		std::vector<VkDescriptorPool> m_descriptorPools;
 		SceneData m_sceneData[2];
 		jsvk::Buffer m_mainBuffer;
+		VkCommandPool m_meshletCommandPool = VK_NULL_HANDLE; // The command buffers of all meshlet game objects
+
+		// The uniform data of the frames, one region of m_uniformBuffer per swapchain image like the command buffers of the
+		// game objects so that a frame never writes what the GPU still reads for another one. A region is the objects, the scene of both
+		// eyes and the cull stats. The descriptors point into the first region and the draws pick the region of their
+		// frame with the dynamic offsets, the whole buffer stays mapped
+		uint32_t m_uniformRegions = 0; // One per swapchain image, an image never shares its region
+		VkDeviceSize m_uniformRegionSize = 0;
+		VkDeviceSize m_objectDynamicAlignment = 0;
+		VkDeviceSize m_sceneOffset = 0; // In a region
+		VkDeviceSize m_statsOffset = 0; // In a region
+		std::vector<ObjectData> m_objectData;			   // What every region holds once it is up to date
+		uint64_t m_objectVersion = 0;					   // Counts the changes of m_objectData
+		std::vector<uint64_t> m_regionVersions;			   // The version of m_objectData each region holds
+
+		uint32_t uniformRegion(uint32_t imageIndex) const { return imageIndex; }
+		uint32_t regionOffset(uint32_t imageIndex) const { return uint32_t(uniformRegion(imageIndex) * m_uniformRegionSize); }
+
+		// Replaces an object, every region takes it before its next frame. A new world matrix of an instance also moves its
+		// bounds, see lod::World::pendingMoves
+		void setObjectData(uint32_t object, const ObjectData &data);
+
+		// Writes the scene and the changed objects into the region of the image and returns it. The frame that read the
+		// region last drew into the same image, so it is done once acquireNextImage waited for the fence of the image
+		char *updateRegion(uint32_t imageIndex);
 
 		// constructor
 		ResourcesMS();
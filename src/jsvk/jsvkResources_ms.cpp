@@ -2,6 +2,8 @@
 #include "jsvkResources.h"
 #include "lodGeometry.hpp"
 #include "lodCamera.hpp"
+#include "lodCulling.hpp"
+#include "lodInstances.hpp"
 
 // std library includes
 #include <array>
@@ -9,6 +11,8 @@
 #include <condition_variable>
 #include <mutex>
 #include <chrono>
+#include <numeric>
+#include <algorithm>
 
 // external includes
 #define GLM_FORCE_RADIANS
@@ -17,6 +21,12 @@
 
 bool SIMPLIFIED = false;
 
+// Underfilled meshlets of this and all coarser LoDs get merged after generation, -1 to disable
+int MERGE_MESHLETS_LOD = 4;
+
+// Store the meshlets of every LoD in the Morton order of their centers so that a cut is a few contiguous ranges
+bool SORT_MESHLETS = true;
+
 extern bool SHOW_MESSAGES;
 
 extern bool INITIALIZED; // Have the simplified models been created?
@@ -74,6 +84,13 @@ namespace jsvk
 			}
 		}
 
+		// Frees the command buffers of all meshlet objects with it
+		if (m_meshletCommandPool != VK_NULL_HANDLE)
+		{
+			vkDestroyCommandPool(m_pVulkanDevice->Device(), m_meshletCommandPool, nullptr);
+			m_meshletCommandPool = VK_NULL_HANDLE;
+		}
+
 		// free descriptorpool
 		if (m_descriptorPools.size() > 0)
 			for (auto descriptorPool : m_descriptorPools)
@@ -352,12 +369,42 @@ namespace jsvk
 
 		// Transform to meshlet
 		mm::makeMesh(&indexVertexMap, &triangles, indices_model.size(), indices_model.data());
-		mm::generateMeshlets(indexVertexMap, triangles, meshlets, vertices.data(), 1);
+		mm::generateMeshlets(indexVertexMap, triangles, meshlets, vertices.data(), 1, mm::MESHLET_PRIMITIVE_LIMIT);
+
+		if (MERGE_MESHLETS_LOD >= 0 && mesh.lod >= MERGE_MESHLETS_LOD)
+		{
+			// keep the fill rate before merging for the report in createWorld
+			mm::collectStats(mm::packNVMeshlets(meshlets), mesh.unmergedStats);
+			mm::mergeMeshlets(meshlets, vertices.data(), mm::MESHLET_PRIMITIVE_LIMIT);
+		}
+
+		if (SORT_MESHLETS)
+		{
+			mm::sortMeshletsSpatially(meshlets, vertices.data());
+		}
+
 		NVMeshlet::Builder<uint32_t>::MeshletGeometry packedMeshlets = mm::packNVMeshlets(meshlets);
 
 		mm::generateEarlyCulling(packedMeshlets, vertices, objectData);
+#if NVMESHLET_VERTEX_DELTA
+		if (!mm::packVertexIndicesDelta(packedMeshlets))
+		{
+			throw std::runtime_error("Vertex indices of " + mesh.name + " do not fit the delta packing!");
+		}
+#endif
+#if NVMESHLET_PRIMITIVE_STRIPS
+		mesh.fittedPrimitiveBytes = packedMeshlets.primitiveIndices.size();
+		if (!mm::packPrimitiveStrips(packedMeshlets))
+		{
+			throw std::runtime_error("Primitive strips of " + mesh.name + " failed to pack!");
+		}
+#endif
 		mm::collectStats(packedMeshlets, stats);
 
+		// model space, the load normalization of the file is part of the model and the placement
+		// of every instance is its own transform, see the ObjectData of the instances in createWorld
+		mesh.geometryHash = mm::hashGeometry(packedMeshlets, vertices.data(), vertices.size());
+
 		mesh.indexVertexMap = indexVertexMap;
 		mesh.meshletCache = meshlets;
 		mesh.triangles = triangles;
@@ -412,11 +459,33 @@ namespace jsvk
 
 		meshlet.vertices = vertices;
 
+		// The normal cone the task shader culls with, so that the renderer can cull the same clusters before drawing them
+		if (meshletIndex < mesh.packedMeshlets.meshletDescriptors.size())
+		{
+			int8_t coneX;
+			int8_t coneY;
+			int8_t coneAngle;
+			mesh.packedMeshlets.meshletDescriptors[meshletIndex].getCone(coneX, coneY, coneAngle);
+
+			NVMeshlet::vec axis = NVMeshlet::oct_to_float32x3(NVMeshlet::vec(float(coneX) / 127.0f, float(coneY) / 127.0f, 0.0f));
+			meshlet.cone = glm::vec4(axis.x, axis.y, axis.z, float(coneAngle) / 127.0f);
+		}
+
+		// The local triangles, used to measure the error of the meshlet when the DAG is created
+		const auto &cache = mesh.meshletCache[meshletIndex];
+		for (uint32_t p = 0; p < cache.numPrims; p++)
+		{
+			if ((cache.primitives[p][0] < vertices.size()) && (cache.primitives[p][1] < vertices.size()) && (cache.primitives[p][2] < vertices.size()))
+			{
+				meshlet.indices.insert(meshlet.indices.end(), {cache.primitives[p][0], cache.primitives[p][1], cache.primitives[p][2]});
+			}
+		}
+
 		mesh.meshlets[meshletIndex] = meshlet;
 	}
 
 	void
-	modelBuilding_task(lod::Mesh &mesh, std::vector<NVMeshlet::Builder<uint32_t>::MeshletGeometry> &meshletGeometry32, std::vector<NVMeshlet::Builder<uint16_t>::MeshletGeometry> &meshletGeometry, std::vector<NVMeshlet::Stats> &stats, std::vector<uint32_t> &vertCount, std::vector<mm::Vertex> &vertices, std::vector<ObjectData> &objectData, std::vector<uint32_t> &indices_model, int modelIndex = 0)
+	modelBuilding_task(lod::Mesh &mesh, std::vector<NVMeshlet::Builder<uint32_t>::MeshletGeometry> &meshletGeometry32, std::vector<NVMeshlet::Builder<uint16_t>::MeshletGeometry> &meshletGeometry, std::vector<NVMeshlet::Stats> &stats, std::vector<uint32_t> &vertCount, std::vector<mm::Vertex> &vertices, std::vector<ObjectData> &objectData, std::vector<uint32_t> &indices_model, std::unordered_map<uint64_t, std::pair<int, size_t>> &uniqueGeometry, int modelIndex = 0)
 	{
 		std::vector<uint32_t> idxList_model;
 		std::vector<mm::Vertex> verts_model;
@@ -437,15 +506,44 @@ namespace jsvk
 
 		world.model.no_triangles.push_back(mesh.no_triangles);
 
-		vertices.insert(vertices.end(), verts_model.begin(), verts_model.end());
-		indices_model.insert(indices_model.end(), idxList_model.begin(), idxList_model.end());
+		// Repeated LoDs and files with the same model space content reuse the uploaded geometry,
+		// instances of a mesh share it anyway and only differ in the worldMatrix of their ObjectData
+		int shared = -1;
+		auto unique = uniqueGeometry.find(mesh.geometryHash);
+		if (unique != uniqueGeometry.end())
+		{
+			const auto &[geometryIndex, vertexBegin] = unique->second;
+			const NVMeshlet::Builder<uint32_t>::MeshletGeometry &other = meshletGeometry32[geometryIndex];
+			if (mm::isSameGeometry(packedMeshlets, verts_model.data(), verts_model.size(), other, &vertices[vertexBegin], vertCount[geometryIndex]))
+			{
+				shared = geometryIndex;
+			}
+		}
+		else
+		{
+			uniqueGeometry[mesh.geometryHash] = {int(meshletGeometry32.size()), vertices.size()};
+		}
+
+		world.model.sharedGeometry.push_back(shared);
 
 		// If each of the models sent in already have their own generated things
 		stats.push_back(mesh.stats.front());
 		objectData.push_back(mesh.objectData.front());
-		vertCount.push_back(verts_model.size());
 
-		meshletGeometry32.push_back(packedMeshlets);
+		if (shared < 0)
+		{
+			vertices.insert(vertices.end(), verts_model.begin(), verts_model.end());
+			indices_model.insert(indices_model.end(), idxList_model.begin(), idxList_model.end());
+
+			vertCount.push_back(verts_model.size());
+			meshletGeometry32.push_back(packedMeshlets);
+		}
+		else
+		{
+			// nothing to upload, loadModel takes the offsets of the shared geometry
+			vertCount.push_back(0);
+			meshletGeometry32.push_back(NVMeshlet::Builder<uint32_t>::MeshletGeometry());
+		}
 
 		mesh.vertices.clear();
 		mesh.indices.clear();
@@ -542,24 +640,10 @@ namespace jsvk
 				// --------------------------------------------------------------------------------------------------------------------------------------
 				if (loaded_files.count(path) != 0)
 				{
-					// The file has already been loaded so just copy the data from the previous model
-					// This is done to avoid loading the same model multiple times and wasting time
+					// The file has already been loaded, the path becomes another instance of the same mesh
 					loaded_files[path]++;
 
-					printf("Model previously loaded copying data: %s LoDs: %d Repeats: %d\r", path.c_str(), MAX_LOD, loaded_files[path]);
-
-					for (int i = 0; i < world.meshes.size(); i++)
-					{
-						if (world.meshes[i].file_path == path)
-						{
-							// TODO: look for better approaches? This is log O(n)
-							std::vector<lod::Mesh>::const_iterator first = world.meshes.begin() + i;
-							std::vector<lod::Mesh>::const_iterator last = world.meshes.begin() + (i + MAX_LOD + 1);
-							std::vector<lod::Mesh> meshes_copy(first, last);
-							world.meshes.insert(world.meshes.end(), meshes_copy.begin(), meshes_copy.end());
-							break;
-						}
-					}
+					printf("Model previously loaded adding instance: %s LoDs: %d Repeats: %d\r", path.c_str(), MAX_LOD, loaded_files[path]);
 
 					index++;
 
@@ -735,8 +819,16 @@ namespace jsvk
 		{
 			completion = 0.0f;
 
+			// Repeated paths are instances of the same mesh and are only deserialized once
+			std::unordered_map<std::string, size_t> unique_paths{};
 			for (auto path : file_paths)
 			{
+				if (unique_paths.count(path) != 0)
+				{
+					continue;
+				}
+				unique_paths[path] = unique_paths.size();
+
 				for (int i = 0; i <= MAX_LOD; i++)
 				{
 					std::thread th = std::thread([i, path]()
@@ -749,12 +841,16 @@ namespace jsvk
 				}
 			}
 
-			synchThreads(threads, (MAX_LOD * file_paths.size()));
+			synchThreads(threads, (MAX_LOD * unique_paths.size()));
+
+			// The threads finish in any order, the LoDs of a mesh have to be next to each other
+			std::stable_sort(world.meshes.begin(), world.meshes.end(), [&unique_paths](const lod::Mesh &a, const lod::Mesh &b)
+							 { return std::make_pair(unique_paths[a.file_path], a.lod) < std::make_pair(unique_paths[b.file_path], b.lod); });
 		}
 
-		// Optional Rotation of repeating models Task
+		// Instance Placement Task
 		// --------------------------------------------------------------------------------------------------------------------------------------
-		// This is to make sure that there are multiple models being loaded/rendered since transform does not work
+		// Every path becomes an instance of its mesh on a grid, the vertices stay in model space and the placement is the world matrix of the instance
 
 		printf("\n\n");
 		printf("Placing models\n");
@@ -762,17 +858,35 @@ namespace jsvk
 		completion = 0.0f;
 		printProgress(completion);
 
-		int grid_size = glm::ceil(glm::sqrt(static_cast<float>(world.meshes.size()))); // Compute the size of the grid
-		float offsetX = 75.5f;														   // X offset (distance between meshes in the x direction)
-		float offsetZ = 75.5f;														   // Z offset (distance between meshes in the z direction)
+		std::unordered_map<std::string, uint32_t> mesh_of_path{};
+		for (uint32_t i = 0; i < world.meshes.size(); i += MAX_LOD + 1)
+		{
+			mesh_of_path.emplace(world.meshes[i].file_path, i / (MAX_LOD + 1));
+		}
+
+		int grid_size = glm::ceil(glm::sqrt(static_cast<float>(file_paths.size() * (MAX_LOD + 1)))); // Compute the size of the grid
+		float offsetX = 75.5f;																		 // X offset (distance between meshes in the x direction)
+		float offsetZ = 75.5f;																		 // Z offset (distance between meshes in the z direction)
 
 		// Calculate starting coordinates so that the first model is in the middle of the grid
 		float startX = -((grid_size / 2) * offsetX);
 		float startZ = -((grid_size / 2) * offsetZ);
 
-		for (int i = 0; i < world.meshes.size(); i++)
+		world.instances.clear();
+		world.mesh_centers.clear();
+
+		for (int p = 0; p < file_paths.size(); p++)
 		{
-			// Compute the grid coordinates for this mesh
+			if (mesh_of_path.count(file_paths[p]) == 0)
+			{
+				throw std::runtime_error("No mesh was loaded for the instance: " + file_paths[p]);
+			}
+
+			lod::Instance instance;
+			instance.mesh = mesh_of_path[file_paths[p]];
+
+			// Compute the grid coordinates for this instance, spaced as when every LoD was its own copy
+			int i = p * (MAX_LOD + 1);
 			int gridX = i % grid_size;
 			int gridZ = i / grid_size;
 
@@ -784,46 +898,26 @@ namespace jsvk
 			// float rotationAngle = glm::radians(90.0f + (i * 5.0f)); // No matter if the meshlets are generated for each of the models separately they still get frustum culled
 			glm::vec3 rotationAxis = glm::vec3(0.0f, 1.0f, 0.0f);
 
-			int temp = i;
-
-			// Change all LODs of this mesh
-			for (int j = 0; j <= MAX_LOD; j++)
-			{
-				auto &mesh = world.meshes[temp];
-				temp++;
-
-				glm::vec3 centroid = glm::vec3(0.0f);
-
-				for (auto &vert : mesh.vertices)
-				{
-					vert.pos += translation;
-
-					glm::mat4 rotationMatrix = glm::rotate(glm::mat4(1.0f), rotationAngle, rotationAxis);
-					vert.pos = glm::vec3(rotationMatrix * glm::vec4(vert.pos, 1.0f));
+			// Translated then rotated around the origin
+			instance.transform = glm::rotate(glm::mat4(1.0f), rotationAngle, rotationAxis) * glm::translate(glm::mat4(1.0f), translation);
+			instance.inverse = glm::inverse(instance.transform);
 
-					if (j == 0)
-					{
-						centroid += vert.pos;
-					}
-				}
-
-				if (j == 0)
-				{
-					centroid /= static_cast<float>(mesh.vertices.size());
+			// The centroid of LoD 0, in model space for the mesh and in world space for the instance
+			lod::Mesh &mesh = world.meshes[instance.mesh * (MAX_LOD + 1)];
 
-					mesh.center = centroid;
-
-					world.mesh_centers.push_back(mesh.center);
-				}
+			glm::vec3 centroid = glm::vec3(0.0f);
+			for (auto &vert : mesh.vertices)
+			{
+				centroid += vert.pos;
 			}
+			centroid /= static_cast<float>(mesh.vertices.size());
 
-			i += MAX_LOD;
+			mesh.center = centroid;
 
-			completion += 1.0f / (world.meshes.size() - i);
-			if (completion > 1.0f)
-			{
-				completion = 1.0f;
-			}
+			world.mesh_centers.push_back(glm::vec3(instance.transform * glm::vec4(centroid, 1.0f)));
+			world.instances.push_back(instance);
+
+			completion += 1.0f / file_paths.size();
 			printProgress(completion);
 		}
 
@@ -905,6 +999,9 @@ namespace jsvk
 				mesh.meshletCache = other.meshletCache;
 				mesh.triangles = other.triangles;
 				mesh.stats = other.stats;
+				mesh.unmergedStats = other.unmergedStats;
+				mesh.fittedPrimitiveBytes = other.fittedPrimitiveBytes;
+				mesh.geometryHash = other.geometryHash;
 				mesh.objectData = other.objectData;
 				mesh.packedMeshlets = other.packedMeshlets;
 				// mesh.center = other.center;
@@ -915,6 +1012,56 @@ namespace jsvk
 			}
 		}
 
+		// Fill rate of the merged LoDs, summed over all meshes
+		if (MERGE_MESHLETS_LOD >= 0)
+		{
+			printf("\n\n");
+			printf("Merged Meshlets\n");
+
+			for (int lod = MERGE_MESHLETS_LOD; lod <= MAX_LOD; lod++)
+			{
+				NVMeshlet::Stats before;
+				NVMeshlet::Stats after;
+				for (auto &mesh : world.meshes)
+				{
+					if (mesh.lod == lod && !mesh.unmergedStats.empty())
+					{
+						before.append(mesh.unmergedStats.front());
+						after.append(mesh.stats.front());
+					}
+				}
+
+				if (before.appended == 0)
+				{
+					continue;
+				}
+
+				printf("LoD %d before: ", lod);
+				before.fprint(stdout);
+				printf("LoD %d after:  ", lod);
+				after.fprint(stdout);
+			}
+		}
+
+#if NVMESHLET_PRIMITIVE_STRIPS
+		// Bytes per triangle of the strips against the fitted uint8 packing
+		{
+			size_t fittedBytes = 0;
+			size_t stripBytes = 0;
+			size_t triangles = 0;
+			for (auto &mesh : world.meshes)
+			{
+				fittedBytes += mesh.fittedPrimitiveBytes;
+				stripBytes += mesh.stats.front().primIndices;
+				triangles += mesh.stats.front().primTotal;
+			}
+
+			printf("\n\n");
+			printf("Primitive Strips\n");
+			printf("fitted: %.2f bytes/triangle, strips: %.2f bytes/triangle\n", double(fittedBytes) / double(triangles), double(stripBytes) / double(triangles));
+		}
+#endif
+
 		// Get Individual Meshlet vertices TASK
 		// This task is a waste of time and should just be taken from the meshlet creation task however I am too lazy to understand that code
 		// --------------------------------------------------------------------------------------------------------------------------------------
@@ -964,7 +1111,7 @@ namespace jsvk
 		completion = 0.0f;
 		printProgress(completion);
 
-		glm::vec3 centerOfAllMeshes = glm::vec3(0.0f);
+		std::vector<glm::vec3> centerOfLoDs(world.meshes.size() / (MAX_LOD + 1), glm::vec3(0.0f)); // Model space, averaged over the LoDs of every unique mesh
 
 		for (int i = 0; i < world.meshes.size(); i++)
 		{
@@ -989,14 +1136,19 @@ namespace jsvk
 				centroid = mesh.center;
 			}
 
-			centerOfAllMeshes += centroid;
+			centerOfLoDs[i / (MAX_LOD + 1)] += centroid / static_cast<float>(MAX_LOD + 1);
 
 			completion += 1.00f / world.meshes.size();
 			printProgress(completion);
 		}
 
 		// Set camera position to be at the center of the first scene
-		centerOfAllMeshes /= static_cast<float>(world.meshes.size());
+		glm::vec3 centerOfAllMeshes = glm::vec3(0.0f);
+		for (auto &instance : world.instances)
+		{
+			centerOfAllMeshes += glm::vec3(instance.transform * glm::vec4(centerOfLoDs[instance.mesh], 1.0f));
+		}
+		centerOfAllMeshes /= static_cast<float>(world.instances.size());
 		world.center = centerOfAllMeshes;
 		glm::vec3 cameraPos = world.center;
 		cameraPos.x -= camera.thresholds[MAX_LOD];
@@ -1009,7 +1161,8 @@ namespace jsvk
 		// Jinsoku coordinate system is -x - x | -y - y | -z - z )
 		if (calcMeshlets)
 		{
-			camera.view = glm::lookAt(camera.position, world.meshes.front().meshlets.front().vertices.front().pos, glm::vec3(0.0f, -1.0f, 0.0f));
+			glm::vec3 target = glm::vec3(world.instances.front().transform * glm::vec4(world.meshes[world.instances.front().mesh * (MAX_LOD + 1)].meshlets.front().vertices.front().pos, 1.0f));
+			camera.view = glm::lookAt(camera.position, target, glm::vec3(0.0f, -1.0f, 0.0f));
 		}
 		else
 		{
@@ -1026,14 +1179,13 @@ namespace jsvk
 			printf("Creating Graph: %s\n", "DAG");
 
 			completion = 0.0f;
-			// This map stores the vertices of each of the LoD meshlets then stores which meshlets have the same vertex
-			std::unordered_map<glm::vec3, std::vector<lod::Graph::Node>, lod::vec3_hash> vertex_to_nodes;
 
-			// A map of all the  nodes in the graph <lod, Node>
-			// std::unordered_map<int, std::vector<lod::Graph::Node>> nodes;
+			world.DAG.clear();
+
+			// Bucket the meshlets by LoD first so that the node ids of one LoD are contiguous
+			std::vector<std::vector<std::pair<int, const lod::Meshlet *>>> levels(MAX_LOD + 1);
 
 			int i = 0;
-			int id = 0;
 			int meshIndex = 0;
 			for (auto &mesh : world.meshes)
 			{
@@ -1044,75 +1196,249 @@ namespace jsvk
 
 				i++;
 
-				// Create the DAG
 				for (auto &meshlet : mesh.meshlets)
 				{
-					lod::Graph::Node node;
-					node.id = id;
-					node.meshIndex = meshIndex;
-					node.meshletIndex = meshlet.index;
-					node.lod = meshlet.lod;
-					node.vertices = meshlet.vertices;
-					node.no_triangles = meshlet.no_triangles;
-					node.center = meshlet.center;
-
-					node.bb.minPoint = meshlet.minPoint;
-					node.bb.maxPoint = meshlet.maxPoint;
-
-					// // A vertex map so that we can easily check the vertices
-					// for (const auto &vert : node.vertices)
-					// {
-					// 	vertex_to_nodes[vert.pos].push_back(node);
-					// }
-
-					id++;
-
-					world.DAG.nodes[node.lod].push_back(node);
+					levels[meshlet.lod].push_back({meshIndex, &meshlet});
+				}
+			}
+
+			std::vector<const lod::Meshlet *> nodeMeshlets; // The meshlet of every node, for measuring the errors
+
+			// Create the DAG
+			for (int lod = 0; lod <= MAX_LOD; lod++)
+			{
+				for (const auto &[index, meshlet] : levels[lod])
+				{
+					lod::BoundingBox bb;
+					bb.minPoint = meshlet->minPoint;
+					bb.maxPoint = meshlet->maxPoint;
+
+					world.DAG.bounds.push_back(bb);
+					world.DAG.centers.push_back(meshlet->center);
+					world.DAG.errors.push_back(0.0f); // Measured once the DAG is linked
+					world.DAG.lods.push_back(uint8_t(lod));
+					world.DAG.cones.push_back(meshlet->cone);
+					world.DAG.meshIndices.push_back(index);
+					world.DAG.meshletIndices.push_back(meshlet->index);
+					world.DAG.triangleCounts.push_back(meshlet->no_triangles);
+
+					nodeMeshlets.push_back(meshlet);
 				}
+
+				world.DAG.levelBegin.push_back(world.DAG.size());
 			}
+			levels.clear();
 
-			// Create parent child relationships based on which meshlets share vertices
-			for (int lod = MAX_LOD; lod > 0; lod--)
+			// The meshes are added in order so the nodes of every mesh are one range per LoD
+			world.DAG.indexMeshes();
+
+			// Create parent child relationships based on which meshlets of the same mesh overlap the parent on the LoD below
+			world.DAG.linkChildren(std::thread::hardware_concurrency());
+
+			// The error of every node against the surface of its children instead of one error per LoD
+			world.DAG.measureErrors(nodeMeshlets, std::thread::hardware_concurrency());
+
+			// Monotonic errors so the renderer can test every node on its own
+			world.DAG.buildErrorBounds();
+
+			completion = 1.0f;
+			printProgress(completion);
+
+#if BENCHMARK
+			// Scaling of the linking on growing prefixes of every LoD, the edges have to match the all-pairs scan
+			printf("\n\n");
+			printf("DAG linking (%u threads)\n", std::thread::hardware_concurrency());
+			printf("%10s %12s %12s %12s %8s\n", "nodes", "grid ms", "all-pairs ms", "grid ns/node", "match");
+
+			for (int fraction = 8; fraction >= 1; fraction /= 2)
 			{
-				for (int i = 0; i < world.DAG.nodes[lod].size(); i++)
+				lod::Graph::DAG subset;
+				for (int lod = 0; lod < int(world.DAG.levels()); lod++)
 				{
-					lod::Graph::Node *parent = &world.DAG.nodes[lod][i];
+					uint32_t first = world.DAG.levelBegin[lod];
+					uint32_t count = world.DAG.levelSize(lod) / fraction;
+
+					for (uint32_t node = first; node < first + count; node++)
+					{
+						subset.bounds.push_back(world.DAG.bounds[node]);
+					}
+					subset.lods.insert(subset.lods.end(), world.DAG.lods.begin() + first, world.DAG.lods.begin() + first + count);
+					subset.meshIndices.insert(subset.meshIndices.end(), world.DAG.meshIndices.begin() + first, world.DAG.meshIndices.begin() + first + count);
+					subset.levelBegin.push_back(subset.size());
+				}
+				subset.indexMeshes();
+
+				auto gridStart = std::chrono::high_resolution_clock::now();
+				subset.linkChildren(std::thread::hardware_concurrency());
+				auto gridStop = std::chrono::high_resolution_clock::now();
+
+				std::vector<uint32_t> gridBegin = subset.childBegin;
+				std::vector<uint32_t> gridChildren = subset.children;
+
+				auto pairsStart = std::chrono::high_resolution_clock::now();
+				subset.linkChildrenAllPairs();
+				auto pairsStop = std::chrono::high_resolution_clock::now();
+
+				double gridTime = std::chrono::duration<double, std::milli>(gridStop - gridStart).count();
+				double pairsTime = std::chrono::duration<double, std::milli>(pairsStop - pairsStart).count();
+				bool match = (gridBegin == subset.childBegin) && (gridChildren == subset.children);
 
-					lod::BoundingBox parent_bb = parent->bb;
+				printf("%10u %12.2f %12.2f %12.1f %8s\n", subset.size(), gridTime, pairsTime, gridTime * 1.0e6 / std::max(subset.size(), 1u), match ? "yes" : "NO");
+			}
+#endif
 
-					// Check the lower level
-					for (int j = 0; j < world.DAG.nodes[lod - 1].size(); j++)
+			// The bounds of every unique mesh in model space and of every instance in world space for culling whole instances
+			{
+				std::vector<lod::BoundingBox> meshBounds;
+				for (uint32_t node = 0; node < world.DAG.size(); node++)
+				{
+					uint32_t mesh = world.DAG.meshIndices[node];
+					lod::BoundingBox bb = world.DAG.bounds[node];
+
+					if (mesh >= meshBounds.size())
 					{
-						lod::Graph::Node *child = &world.DAG.nodes[lod - 1][j];
+						meshBounds.resize(mesh + 1, bb);
+					}
 
-						lod::BoundingBox child_bb = child->bb;
+					meshBounds[mesh].minPoint = glm::min(meshBounds[mesh].minPoint, bb.minPoint);
+					meshBounds[mesh].maxPoint = glm::max(meshBounds[mesh].maxPoint, bb.maxPoint);
+				}
+
+				world.mesh_bounds.clear();
+				for (auto &bb : meshBounds)
+				{
+					world.mesh_bounds.push_back(bb);
+				}
+
+				world.instance_bounds.clear();
+				for (auto &instance : world.instances)
+				{
+					world.instance_bounds.push_back(lod::transformBounds(meshBounds[instance.mesh], instance.transform));
+				}
+			}
+
+			// The coarsest LoD of every mesh as occluders, the roots are grouped by mesh
+			{
+				std::vector<std::vector<uint32_t>> meshRoots(world.mesh_bounds.size());
+				for (uint32_t root = world.DAG.levelBegin[MAX_LOD]; root < world.DAG.levelBegin[MAX_LOD + 1]; root++)
+				{
+					meshRoots[world.DAG.meshIndices[root]].push_back(root);
+				}
 
-						if (parent_bb.isContained(parent_bb, child_bb) && (parent->children.count(child->id) == 0))
+				world.occluderPositions.clear();
+				world.occluderMargins.clear();
+				world.occluderBegin.assign(1, 0);
+
+				for (auto &roots : meshRoots)
+				{
+					for (uint32_t root : roots)
+					{
+						const lod::Meshlet &meshlet = *nodeMeshlets[root];
+						for (size_t i = 0; i + 2 < meshlet.indices.size(); i += 3)
 						{
-							parent->children[child->id] = child;
+							for (int v = 0; v < 3; v++)
+							{
+								world.occluderPositions.push_back(meshlet.vertices[meshlet.indices[i + v]].pos);
+							}
+							world.occluderMargins.push_back(world.DAG.errors[root]);
 						}
 					}
 
-					// The following is if we want one level of shared vertices
-					// for (auto &vert : parent->vertices)
-					// {
-					// 	// Lookup nodes sharing the vertex
-					// 	auto &potential_children = vertex_to_nodes[vert.pos];
-
-					// 	for (auto &kid : potential_children)
-					// 	{
-					// 		// Check if potential_child is already a child of the parent
-					// 		if ((kid.lod == lod - 1) && (parent->children.count(kid.id) == 0))
-					// 		{
-					// 			parent->children[kid.id] = kid;
-					// 		}
-					// 	}
-					// }
+					world.occluderBegin.push_back(uint32_t(world.occluderMargins.size()));
 				}
+			}
 
-				completion += 1.00f / (MAX_LOD);
-				printProgress(completion);
+#if BENCHMARK
+			// Frustum culling of every DAG node in id order, looking at the scene from the starting position
+			{
+				lod::Camera cullCamera = camera;
+				cullCamera.projection = glm::perspective(glm::radians(cullCamera.fov), float(cullCamera.res.x) / float(cullCamera.res.y), 0.1f, 10000.0f);
+				lod::buildFrustum(cullCamera);
+
+				lod::FrustumPlanes planes(cullCamera.frustum);
+				std::vector<uint32_t> nodes(world.DAG.size());
+				std::iota(nodes.begin(), nodes.end(), 0);
+				std::vector<lod::CullResult> scalarResults(nodes.size());
+				std::vector<lod::CullResult> kernelResults(nodes.size());
+
+				const int repeats = 20;
+
+				auto scalarStart = std::chrono::high_resolution_clock::now();
+				for (int r = 0; r < repeats; r++)
+				{
+					lod::cullBounds_scalar(planes, world.DAG.bounds, nodes.data(), uint32_t(nodes.size()), scalarResults.data());
+				}
+				auto scalarStop = std::chrono::high_resolution_clock::now();
+
+				for (int r = 0; r < repeats; r++)
+				{
+					lod::cullBounds(planes, world.DAG.bounds, nodes.data(), uint32_t(nodes.size()), kernelResults.data());
+				}
+				auto kernelStop = std::chrono::high_resolution_clock::now();
+
+				double scalarTime = std::chrono::duration<double, std::nano>(scalarStop - scalarStart).count();
+				double kernelTime = std::chrono::duration<double, std::nano>(kernelStop - scalarStop).count();
+				bool match = scalarResults == kernelResults;
+
+				printf("\n\n");
+				printf("Frustum culling %u nodes\n", world.DAG.size());
+				printf("scalar: %.3f nodes/ns, %s: %.3f nodes/ns, match: %s\n", nodes.size() * repeats / scalarTime, lod::cullBoundsKernel(), nodes.size() * repeats / kernelTime, match ? "yes" : "NO");
+			}
+
+			// Instance culling through the BVH against testing every instance box on its own, from the starting position
+			{
+				lod::Camera cullCamera = camera;
+				cullCamera.projection = glm::perspective(glm::radians(cullCamera.fov), float(cullCamera.res.x) / float(cullCamera.res.y), 0.1f, 10000.0f);
+				lod::buildFrustum(cullCamera);
+
+				lod::FrustumPlanes planes(cullCamera.frustum);
+				const uint32_t instanceCount = uint32_t(world.instance_bounds.size());
+				const int repeats = 20;
+
+				auto buildStart = std::chrono::high_resolution_clock::now();
+				lod::InstanceBVH bvh;
+				bvh.build(world.instance_bounds, std::thread::hardware_concurrency());
+				auto buildStop = std::chrono::high_resolution_clock::now();
+
+				std::vector<uint32_t> bvhVisible;
+				for (int r = 0; r < repeats; r++)
+				{
+					bvhVisible.clear();
+					bvh.query(world.instance_bounds, planes, cullCamera.position, cullCamera.cullDistance, bvhVisible);
+				}
+				auto bvhStop = std::chrono::high_resolution_clock::now();
+
+				std::vector<uint32_t> instances(instanceCount);
+				std::iota(instances.begin(), instances.end(), 0);
+				std::vector<lod::CullResult> results(instanceCount);
+				std::vector<uint32_t> linearVisible;
+				for (int r = 0; r < repeats; r++)
+				{
+					linearVisible.clear();
+					lod::cullBounds(planes, world.instance_bounds, instances.data(), instanceCount, results.data());
+					for (uint32_t i = 0; i < instanceCount; i++)
+					{
+						lod::BoundingBox bb = world.instance_bounds[i];
+						if ((results[i] != lod::CULL_OUTSIDE) && (glm::distance(glm::clamp(cullCamera.position, bb.minPoint, bb.maxPoint), cullCamera.position) <= cullCamera.cullDistance))
+						{
+							linearVisible.push_back(i);
+						}
+					}
+				}
+				auto linearStop = std::chrono::high_resolution_clock::now();
+
+				std::sort(bvhVisible.begin(), bvhVisible.end());
+				double buildTime = std::chrono::duration<double, std::micro>(buildStop - buildStart).count();
+				double bvhTime = std::chrono::duration<double, std::micro>(bvhStop - buildStop).count() / repeats;
+				double linearTime = std::chrono::duration<double, std::micro>(linearStop - bvhStop).count() / repeats;
+
+				printf("\n");
+				printf("Instance culling %u instances, %u BVH nodes built in %.1f us\n", instanceCount, bvh.size(), buildTime);
+				printf("linear: %.1f us, BVH: %.1f us, %zu visible, match: %s\n", linearTime, bvhTime, bvhVisible.size(), bvhVisible == linearVisible ? "yes" : "NO");
 			}
+#endif
+
+			printf("\nDAG: %u nodes, %zu edges, %.2f MB shared by %zu instances of %zu meshes\n", world.DAG.size(), world.DAG.children.size(), world.DAG.memoryUsage() / (1024.0 * 1024.0), world.instances.size(), world.mesh_bounds.size());
 
 			completion = 0;
 			printProgress(completion);
@@ -1131,6 +1457,7 @@ namespace jsvk
 		std::vector<mm::Vertex> vertices{0};
 		std::vector<ObjectData> objectData;
 		std::vector<uint32_t> indices_model;
+		std::unordered_map<uint64_t, std::pair<int, size_t>> uniqueGeometry;
 
 		completion = 0.0f;
 
@@ -1142,7 +1469,7 @@ namespace jsvk
 			completion += 1.0f / (world.meshes.size());
 			printProgress(completion);
 			// If each of the meshes (LoDs included) should be treated separately making multiple game objects
-			modelBuilding_task(mesh, meshletGeometry32, meshletGeometry, stats, vertCount, vertices, objectData, indices_model);
+			modelBuilding_task(mesh, meshletGeometry32, meshletGeometry, stats, vertCount, vertices, objectData, indices_model, uniqueGeometry);
 
 			// What is the lowest LoD model that could be used for the scene
 			if (mesh.lod > lowestLoD)
@@ -1151,12 +1478,25 @@ namespace jsvk
 			}
 		}
 
+		// One object per instance with the world matrix of the instance, the last one is for the offset game object
+		std::vector<ObjectData> instanceData;
+		for (auto &instance : world.instances)
+		{
+			ObjectData data = objectData[instance.mesh * (MAX_LOD + 1)];
+			data.worldMatrix = instance.transform * data.worldMatrix;
+			data.worldMatrixIT = glm::transpose(glm::inverse(data.worldMatrix));
+			data.winding = glm::determinant(data.worldMatrix) > 0 ? 1.0f : -2.0f;
+
+			instanceData.push_back(data);
+		}
+		instanceData.push_back(instanceData.front());
+
 		world.model.meshletGeometry32 = meshletGeometry32;
 		world.model.meshletGeometry = meshletGeometry;
 		world.model.stats = stats;
 		world.model.vertCount = vertCount;
 		world.model.vertices = vertices;
-		world.model.objectData = objectData;
+		world.model.objectData = instanceData;
 		world.model.indices = indices_model;
 		world.lowestLod = lowestLoD;
 
@@ -1229,6 +1569,28 @@ namespace jsvk
 
 		m_geos.resize(num_models16 + num_models32 + 1);
 
+#if NVMESHLET_VERTEX_DELTA
+		// only the 32 bit geometry is delta packed, meshletTexture.mesh reads the plain 16 bit indices
+		if (num_models16 > 0)
+		{
+			throw std::runtime_error("Textured models can not be drawn with NVMESHLET_VERTEX_DELTA enabled!");
+		}
+#endif
+#if NVMESHLET_VERTEX_QUANTIZED
+		// the quantized stream replaces the float vbo and abo that meshletTexture.mesh reads
+		if (num_models16 > 0)
+		{
+			throw std::runtime_error("Textured models can not be drawn with NVMESHLET_VERTEX_QUANTIZED enabled!");
+		}
+#endif
+#if NVMESHLET_PRIMITIVE_STRIPS
+		// only the 32 bit geometry is strip packed, meshletTexture.mesh reads the uint8 triangle lists
+		if (num_models16 > 0)
+		{
+			throw std::runtime_error("Textured models can not be drawn with NVMESHLET_PRIMITIVE_STRIPS enabled!");
+		}
+#endif
+
 		// set pipeline for vr models
 		if (num_models16 + num_models32 >= 2)
 		{
@@ -1250,13 +1612,41 @@ namespace jsvk
 			else {
 				m_geos[i].vbo_offset = vertCount[i] + vertCount[i - 1];
 			}*/
-			m_geos[i].desc_offset = (stats[i - 1].meshletsTotal * sizeof(NVMeshlet::MeshletDesc)) + m_geos[i - 1].desc_offset;
-			m_geos[i].prim_offset = (stats[i - 1].primIndices * sizeof(NVMeshlet::PrimitiveIndexType)) + m_geos[i - 1].prim_offset;
-			m_geos[i].vert_offset = (stats[i - 1].vertexIndices * (m_geos[i - 1].shorts == 1 ? sizeof(uint16_t) : sizeof(uint32_t))) + m_geos[i - 1].vert_offset;
-			m_geos[i].vbo_offset = (vertCount[i - 1] * (3 * sizeof(float))) + m_geos[i - 1].vbo_offset;
+			// geometry that is shared with an earlier one takes up no space
+			bool uploaded = world.model.sharedGeometry[i - 1] < 0;
+
+			m_geos[i].desc_offset = (uploaded ? stats[i - 1].meshletsTotal * sizeof(NVMeshlet::MeshletDesc) : 0) + m_geos[i - 1].desc_offset;
+			m_geos[i].prim_offset = (uploaded ? stats[i - 1].primIndices * sizeof(NVMeshlet::PrimitiveIndexType) : 0) + m_geos[i - 1].prim_offset;
+			m_geos[i].vert_offset = (uploaded ? stats[i - 1].vertexIndices * (m_geos[i - 1].shorts == 1 ? sizeof(uint16_t) : sizeof(uint32_t)) : 0) + m_geos[i - 1].vert_offset;
+#if NVMESHLET_VERTEX_QUANTIZED
+			// the bounds in front of every uploaded mesh take up a whole number of vertices
+			size_t header = uploaded ? NVMESHLET_VERTEX_QUANTIZED_HEADER * sizeof(uint32_t) : 0;
+			m_geos[i].vbo_offset = header + (vertCount[i - 1] * mm::VBO_VERTEX_STRIDE) + m_geos[i - 1].vbo_offset;
+#else
+			m_geos[i].vbo_offset = (vertCount[i - 1] * mm::VBO_VERTEX_STRIDE) + m_geos[i - 1].vbo_offset;
+#endif
 
 			m_geos[i - 1].desc_count = stats[i - 1].meshletsTotal;
 		}
+
+		// Identical geometry was only uploaded once, point the copies at it
+		size_t sharedCount = 0;
+		for (int i = 0; i < world.model.sharedGeometry.size(); ++i)
+		{
+			int shared = world.model.sharedGeometry[i];
+			if (shared >= 0)
+			{
+				m_geos[i].desc_offset = m_geos[shared].desc_offset;
+				m_geos[i].prim_offset = m_geos[shared].prim_offset;
+				m_geos[i].vert_offset = m_geos[shared].vert_offset;
+				m_geos[i].vbo_offset = m_geos[shared].vbo_offset;
+				sharedCount++;
+			}
+		}
+		if (SHOW_MESSAGES)
+		{
+			std::cout << sharedCount << " of " << world.model.sharedGeometry.size() << " geometries share their buffers with an identical one." << std::endl;
+		}
 		// m_geos[1].vbo_offset = 0;
 		//  if model is split into several meshlets we need this
 		//  i should be 3 when controllers are present 1 when they are not
@@ -1265,8 +1655,40 @@ namespace jsvk
 		// }
 		//
 
+#if NVMESHLET_VERTEX_QUANTIZED
+		// one quantized stream for position and normal, replaces the float vbo and abo
+		std::vector<uint32_t> quantizedVerts;
+		{
+			size_t vertexOffset = 0;
+			for (size_t i = 0; i < vertCount.size(); ++i)
+			{
+				if (world.model.sharedGeometry[i] >= 0)
+				{
+					continue;
+				}
+
+				size_t streamOffset = quantizedVerts.size();
+				mm::quantizeVertices(&vertices[vertexOffset], vertCount[i], quantizedVerts);
+
+				float positionError;
+				float normalError;
+				if (!mm::checkQuantizedVertices(&vertices[vertexOffset], vertCount[i], &quantizedVerts[streamOffset], positionError, normalError))
+				{
+					throw std::runtime_error("Quantized positions exceed the error bound!");
+				}
+				if (SHOW_MESSAGES)
+				{
+					std::cout << "Quantized mesh " << i << ": max position error " << positionError << ", max normal error " << normalError << " degrees." << std::endl;
+				}
+
+				vertexOffset += vertCount[i];
+			}
+		}
+#endif
+
 		//  this is not needed anymore?!
 		vertCount.clear();
+		world.model.sharedGeometry.clear();
 
 		// This is the easiest way of implementing a single object per mesh and not per LoD  so that it still generates all the below stuff correctly.
 		{
@@ -1288,8 +1710,9 @@ namespace jsvk
 			{
 				// if (world.mesh_paths[i] != previous_path)
 				// {
-				GameObject original = m_geos[i * (MAX_LOD + 1)];
-				original.center = world.meshes[i * (MAX_LOD + 1)].center;
+				// One game object per instance, it is the LoD 0 object of its mesh and its ObjectOffset is the instance
+				GameObject original = m_geos[world.instances[i].mesh * (MAX_LOD + 1)];
+				original.center = world.mesh_centers[i];
 				m_geos_temp.push_back(original);
 				// }
 
@@ -1311,6 +1734,13 @@ namespace jsvk
 
 		// set up scene based on the meshes and init cmdpool and cmdbuffer
 		int offset = 0;
+
+		VkCommandPoolCreateInfo meshletPoolInfo = jsvk::init::commandPoolCreateInfo();
+		meshletPoolInfo.queueFamilyIndex = jsvk::findQueueFamilies(m_pVulkanDevice->m_pPhysicalDevice, m_pPresenter->getSurface()).graphicsFamily.value();
+		meshletPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+		VK_CHECK(vkCreateCommandPool(m_pVulkanDevice->Device(), &meshletPoolInfo, nullptr, &m_meshletCommandPool));
+
 		// should -1 here too.
 		for (GameObject &object : m_geos)
 		{
@@ -1339,28 +1769,25 @@ namespace jsvk
 			// TODO: Find a better solution? This is a lot of wasted space and resources
 			// This will also not generate a command buffer for the last game object which is the offset object since it has no meshlets
 
-			for (int i = 0; i < (object.desc_count * 2); ++i)
+			// The meshlet objects only differ in their command buffers, which all come from m_meshletCommandPool and are
+			// only recorded on the render thread
+			std::vector<VkCommandBuffer> meshletBuffers(size_t(object.desc_count) * 2 * 3);
+			if (!meshletBuffers.empty())
 			{
+				VkCommandBufferAllocateInfo meshletAllocInfo = jsvk::init::commandBufferAllocateInfo();
+				meshletAllocInfo.commandPool = m_meshletCommandPool;
+				meshletAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+				meshletAllocInfo.commandBufferCount = (uint32_t)meshletBuffers.size();
+
+				VK_CHECK(vkAllocateCommandBuffers(m_pVulkanDevice->Device(), &meshletAllocInfo, meshletBuffers.data()));
+			}
 
+			for (int i = 0; i < (object.desc_count * 2); ++i)
+			{
 				GameObject meshletObject;
-				jsvk::QueueFamilyIndices queueFamilyIndices;
-				queueFamilyIndices = jsvk::findQueueFamilies(m_pVulkanDevice->m_pPhysicalDevice, m_pPresenter->getSurface());
 				meshletObject.ObjectOffset = offset;
-				// ++offset;
-				VkCommandPoolCreateInfo poolInfo = jsvk::init::commandPoolCreateInfo();
-				poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
-				poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-
-				vkCreateCommandPool(m_pVulkanDevice->Device(), &poolInfo, nullptr, &meshletObject.m_commandPool);
-
-				meshletObject.m_commandBuffers.resize(3);
-
-				VkCommandBufferAllocateInfo allocInfo = jsvk::init::commandBufferAllocateInfo();
-				allocInfo.commandPool = meshletObject.m_commandPool;
-				allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
-				allocInfo.commandBufferCount = (uint32_t)meshletObject.m_commandBuffers.size();
-
-				vkAllocateCommandBuffers(m_pVulkanDevice->Device(), &allocInfo, meshletObject.m_commandBuffers.data());
+				meshletObject.m_commandPool = m_meshletCommandPool;
+				meshletObject.m_commandBuffers.assign(meshletBuffers.begin() + i * 3, meshletBuffers.begin() + (i + 1) * 3);
 
 				world.gameObjects.push_back(meshletObject);
 			}
@@ -1486,6 +1913,11 @@ namespace jsvk
 			texCoords.push_back(vertices.at(i).texCoord.y);
 		}
 
+#if NVMESHLET_VERTEX_QUANTIZED
+		// the normals are part of the quantized stream, keep a single
+		// attribute so the abo binding stays valid
+		attributes.resize(3, 0.0f);
+#else
 		for (int i = controller_verts; i < vertices.size(); ++i)
 		{
 			verts.push_back(vertices.at(i).pos.x);
@@ -1496,6 +1928,7 @@ namespace jsvk
 			attributes.push_back(vertices.at(i).color.y);
 			attributes.push_back(vertices.at(i).color.z);
 		}
+#endif
 
 		// Dont need these no more I think ?
 		vertices.clear();
@@ -1535,7 +1968,13 @@ namespace jsvk
 		VkDeviceSize m_maxIboChunk = std::min(iboMax, maxChunk);
 		VkDeviceSize m_maxMeshChunk = std::min(meshMax, maxChunk);
 
+#if NVMESHLET_VERTEX_QUANTIZED
+		void *vboData = quantizedVerts.data();
+		VkDeviceSize vboSize = quantizedVerts.size() * sizeof(uint32_t);
+#else
+		void *vboData = verts.data();
 		VkDeviceSize vboSize = verts.size() * sizeof(float);
+#endif
 		VkDeviceSize aboSize = attributes.size() * sizeof(float);
 		VkDeviceSize texboSize = texCoords.size() * sizeof(float);
 		VkDeviceSize meshSize = NVMeshlet::computeCommonAlignedSize(descSize) + NVMeshlet::computeCommonAlignedSize(primSize) + NVMeshlet::computeCommonAlignedSize(vertexSize);
@@ -1554,7 +1993,7 @@ namespace jsvk
 		jsvk::Buffer stagingBuffer;
 		m_pVulkanDevice->createBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stagingBuffer, vboSize + aboSize + texboSize + meshSize);
 		stagingBuffer.map();
-		stagingBuffer.copyTo(verts.data(), vboSize);
+		stagingBuffer.copyTo(vboData, vboSize);
 		stagingBuffer.unmap();
 		stagingBuffer.map(vboSize, aboSize);
 		stagingBuffer.copyTo(attributes.data(), aboSize);
@@ -1600,32 +2039,53 @@ namespace jsvk
 			objectDynamicAlignment = (objectDynamicAlignment + minUboAlignment - 1) & ~(minUboAlignment - 1);
 		}
 
-		VkDeviceSize bufferSize = (VkDeviceSize)64 + 2 * m_dynamicAlignment + (num_models16 + num_models32) * objectDynamicAlignment + sizeof(CullStats);
-		// we multiply by 2 because we have left and right eye view
-		VkDeviceSize totalSize = bufferSize * 2;
+		// One object per instance, see createWorld
+		size_t num_objects = objectData.size();
+		m_objectDynamicAlignment = objectDynamicAlignment;
+		m_objectData = objectData;
+
+		// A region is the objects, the scene of both eyes and the cull stats. It is rounded up so the dynamic offsets of
+		// the uniform and the storage descriptors both land on their alignment
+		VkDeviceSize regionAlignment = std::max(minUboAlignment, m_pVulkanDevice->m_deviceProperties.limits.minStorageBufferOffsetAlignment);
+		m_sceneOffset = num_objects * objectDynamicAlignment;
+		m_statsOffset = m_sceneOffset + 2 * m_dynamicAlignment;
+		m_uniformRegionSize = m_statsOffset + sizeof(CullStats);
+
+		if (regionAlignment > 0)
+		{
+			m_uniformRegionSize = (m_uniformRegionSize + regionAlignment - 1) & ~(regionAlignment - 1);
+		}
+
+		m_uniformRegions = std::max<uint32_t>(uint32_t(m_pPresenter->getImageViews().size()), 1);
+		m_regionVersions.assign(m_uniformRegions, 0);
+
+		VkDeviceSize bufferSize = m_uniformRegions * m_uniformRegionSize;
 
 		VK_CHECK(m_pVulkanDevice->createBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &m_uniformBuffer, bufferSize, nullptr, true));
 
-		// initial fill of object data
+		// initial fill of every region, the buffer stays mapped as a whole
 		char *uniformChar = (char *)m_uniformBuffer.m_mapped;
 		DynamicObjectDataPointer = m_uniformBuffer.m_mapped;
 
-		for (int i = 0; i < (num_models16 + num_models32); ++i)
+		for (uint32_t region = 0; region < m_uniformRegions; ++region)
 		{
-			memcpy(&uniformChar[i * objectDynamicAlignment], &objectData[i], sizeof(ObjectData));
-		}
+			char *regionChar = &uniformChar[region * m_uniformRegionSize];
+
+			for (int i = 0; i < num_objects; ++i)
+			{
+				memcpy(&regionChar[i * objectDynamicAlignment], &objectData[i], sizeof(ObjectData));
+			}
 
-		// segfaults the shit out of me!
-		memcpy(&uniformChar[(VkDeviceSize)64 + 2 * m_dynamicAlignment + (num_models16 + num_models32) * objectDynamicAlignment], m_cullStats, sizeof(CullStats));
+			memcpy(&regionChar[m_statsOffset], m_cullStats, sizeof(CullStats));
 
-		m_uniformBuffer.unmap();
-		m_uniformBuffer.map((num_models16 + num_models32) * objectDynamicAlignment, 2 * m_dynamicAlignment);
+			m_regionVersions[region] = m_objectVersion;
+		}
 
 		VkPipelineStageFlags stageMesh = VK_SHADER_STAGE_MESH_BIT_NV;
 		VkPipelineStageFlags stageTask = VK_SHADER_STAGE_TASK_BIT_NV;
 
 		// bindings for pipeline
-		VkDescriptorSetLayoutBinding sceneBindings[2];
+		VkDescriptorSetLayoutBinding sceneBindings[2] = {};
 		sceneBindings[0].binding = 0;
 		sceneBindings[0].descriptorCount = 1;
 		sceneBindings[0].stageFlags = stageTask | stageMesh | VK_SHADER_STAGE_FRAGMENT_BIT;
@@ -1634,7 +2094,7 @@ namespace jsvk
 		sceneBindings[1].binding = 1;
 		sceneBindings[1].descriptorCount = 1;
 		sceneBindings[1].stageFlags = stageTask | stageMesh;
-		sceneBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		sceneBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
 
 		VkDescriptorSetLayoutCreateInfo sceneLayoutInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
 		sceneLayoutInfo.bindingCount = 2;
@@ -1745,7 +2205,7 @@ namespace jsvk
 		std::array<VkDescriptorPoolSize, 2> scene_poolSizes = {};
 		scene_poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 		scene_poolSizes[0].descriptorCount = static_cast<uint32_t>(1);
-		scene_poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		scene_poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
 		scene_poolSizes[1].descriptorCount = static_cast<uint32_t>(1);
 
 		VkDescriptorPoolCreateInfo poolInfo = jsvk::init::descriptorPoolCreateInfo();
@@ -1767,9 +2227,11 @@ namespace jsvk
 
 		result = vkAllocateDescriptorSets(m_pVulkanDevice->Device(), &allocInfo, sceneSets.data());
 
+		// The uniform buffer descriptors point into the first region, the draws move them to the region of their frame
+		// with the dynamic offsets, see regionOffset
 		VkDescriptorBufferInfo offScreenBufferInfo = {};
 		offScreenBufferInfo.buffer = m_uniformBuffer.m_pBuffer;
-		offScreenBufferInfo.offset = (num_models16 + num_models32) * objectDynamicAlignment;
+		offScreenBufferInfo.offset = m_sceneOffset;
 		offScreenBufferInfo.range = m_dynamicAlignment;
 
 		VkWriteDescriptorSet uniformDescriptor = jsvk::init::writeDescriptorSet();
@@ -1784,14 +2246,14 @@ namespace jsvk
 
 		offScreenBufferInfo = {};
 		offScreenBufferInfo.buffer = m_uniformBuffer.m_pBuffer;
-		offScreenBufferInfo.offset = (num_models16 + num_models32) * objectDynamicAlignment + 2 * m_dynamicAlignment;
+		offScreenBufferInfo.offset = m_statsOffset;
 		offScreenBufferInfo.range = sizeof(CullStats);
 
 		uniformDescriptor = jsvk::init::writeDescriptorSet();
 		uniformDescriptor.dstBinding = 1;
 		uniformDescriptor.dstSet = sceneSets[0];
 		uniformDescriptor.dstArrayElement = 0;
-		uniformDescriptor.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		uniformDescriptor.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
 		uniformDescriptor.descriptorCount = 1;
 		uniformDescriptor.pBufferInfo = &offScreenBufferInfo;
 
@@ -2013,6 +2475,47 @@ namespace jsvk
 		return 1;
 	}
 
+	void ResourcesMS::setObjectData(uint32_t object, const ObjectData &data)
+	{
+		// Object i is instance i, a new world matrix moves the instance by the same amount. The selection may still read
+		// the instances, so the move waits in pendingMoves until the renderer applies it. The last object is the offset game object
+		if ((object < world.instances.size()) && (data.worldMatrix != m_objectData[object].worldMatrix))
+		{
+			world.pendingMoves.push_back({object, data.worldMatrix * glm::inverse(m_objectData[object].worldMatrix)});
+		}
+
+		m_objectData[object] = data;
+		m_objectVersion++;
+	}
+
+	char *ResourcesMS::updateRegion(uint32_t imageIndex)
+	{
+		uint32_t region = uniformRegion(imageIndex);
+		char *regionChar = (char *)m_uniformBuffer.m_mapped + region * m_uniformRegionSize;
+
+		// The objects only change through setObjectData, a region takes all of them again once it missed a change
+		if (m_regionVersions[region] != m_objectVersion)
+		{
+			if (m_objectDynamicAlignment == sizeof(ObjectData))
+			{
+				memcpy(regionChar, m_objectData.data(), m_objectData.size() * sizeof(ObjectData));
+			}
+			else
+			{
+				for (size_t i = 0; i < m_objectData.size(); ++i)
+				{
+					memcpy(&regionChar[i * m_objectDynamicAlignment], &m_objectData[i], sizeof(ObjectData));
+				}
+			}
+
+			m_regionVersions[region] = m_objectVersion;
+		}
+
+		memcpy(&regionChar[m_sceneOffset], &m_sceneData[0], sizeof(SceneData));
+
+		return regionChar;
+	}
+
 	void ResourcesMS::createRenderPass()
 	{
 
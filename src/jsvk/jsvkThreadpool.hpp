@@ -1,3 +1,5 @@
+#pragma once
+
 /*
 This code is based on sascha willems git repo on multi treaded command buffer recording
 https://github.com/SaschaWillems/Vulkan/blob/master/base/threadpool.hpp 
@@ -10,6 +12,7 @@ and on Herb Sutter's blog (https://herbsutter.com/gotw/_102/)
 #include <mutex>
 #include <condition_variable>
 #include <functional>
+#include <memory>
 
 
 template<typename T, typename ...Args>
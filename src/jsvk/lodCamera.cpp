@@ -4,6 +4,7 @@
 #include <chrono>
 #include <algorithm>
 #include <array>
+#include <cmath>
 
 #define GLM_FORCE_RADIANS
 #include <glm/glm.hpp>
@@ -116,6 +117,15 @@ namespace lod
         return fov;
     }
 
+    static glm::vec3 forwardDirection(float yaw, float pitch)
+    {
+        glm::vec3 forward;
+        forward.x = glm::cos(glm::radians(yaw)) * glm::cos(glm::radians(pitch));
+        forward.y = glm::sin(glm::radians(pitch));
+        forward.z = glm::sin(glm::radians(yaw)) * glm::cos(glm::radians(pitch));
+        return forward;
+    }
+
     void buildFrustum(Camera &cam)
     {
         glm::mat4 view = cam.view;
@@ -171,6 +181,54 @@ namespace lod
         cam.frustum = frustum;
     }
 
+    Camera predictCamera(const Camera &cam, float ms)
+    {
+        Camera predicted = cam;
+        predicted.position += cam.velocity * ms;
+        predicted.yaw += cam.angularVelocity.x * ms;
+        predicted.pitch = glm::clamp(cam.pitch + cam.angularVelocity.y * ms, -89.99f, 89.99f);
+
+        glm::vec3 up(0.0f, 1.0f, 0.0f);
+        predicted.view = glm::lookAt(predicted.position, predicted.position + forwardDirection(predicted.yaw, predicted.pitch), up);
+
+        buildFrustum(predicted);
+        return predicted;
+    }
+
+    void FrameTimeController::update(float frameMs)
+    {
+        smoothedMs = (smoothedMs == 0.0f) ? frameMs : (smoothedMs * 0.9f + frameMs * 0.1f);
+
+        if (!enabled)
+        {
+            scale = 1.0f;
+            integral = 0.0f;
+            lastError = 0.0f;
+            return;
+        }
+
+        float error = 0.0f;
+        if (std::abs(smoothedMs - targetMs) > deadbandMs)
+        {
+            error = (smoothedMs - targetMs) / targetMs;
+            if (error < 0.0f)
+            {
+                error *= recovery;
+            }
+        }
+
+        const float maxLog = std::log(maxScale);
+        const float minLog = std::log(minScale);
+
+        // Anti windup: the integral alone can never push the scale past its limits
+        integral = std::clamp(integral + error, minLog / ki, maxLog / ki);
+
+        float output = kp * error + ki * integral + kd * (error - lastError);
+        lastError = error;
+
+        scale = std::exp(std::clamp(output, minLog, maxLog));
+    }
+
     void updateCamera(
         GLFWwindow *_pWindow,
         float _deltaTime,
@@ -183,14 +241,13 @@ namespace lod
         _cam.aspect = float(framebufferWidth) / float(framebufferHeight);
 
         glm::vec2 lookDirection = getLookDirection(_pWindow);
+        glm::vec2 oldAngles(_cam.yaw, _cam.pitch);
         _cam.yaw += lookDirection.y * _deltaTime * _cam.sensitivity;
         _cam.pitch += lookDirection.x * _deltaTime * _cam.sensitivity;
         _cam.pitch = glm::clamp(_cam.pitch, -89.99f, 89.99f);
+        _cam.angularVelocity = (glm::vec2(_cam.yaw, _cam.pitch) - oldAngles) / _deltaTime;
 
-        glm::vec3 forward;
-        forward.x = glm::cos(glm::radians(_cam.yaw)) * glm::cos(glm::radians(_cam.pitch));
-        forward.y = glm::sin(glm::radians(_cam.pitch));
-        forward.z = glm::sin(glm::radians(_cam.yaw)) * glm::cos(glm::radians(_cam.pitch));
+        glm::vec3 forward = forwardDirection(_cam.yaw, _cam.pitch);
 
         float moveSpeed = 0.0f;
         if (glfwGetKey(_pWindow, keys.moveBoost) == GLFW_PRESS)
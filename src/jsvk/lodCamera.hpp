@@ -8,6 +8,7 @@
 #include <glm/glm.hpp>
 
 #include <chrono>
+#include <limits>
 #include <vector>
 #include <unordered_map>
 
@@ -30,6 +31,41 @@ namespace lod
         int y = 720;
     }; // struct resolution
 
+    // Holds a target frame time by scaling how much error the LoD selection accepts. A PID on the relative frame time
+    // error drives the log of the scale, inside the deadband the integral holds so the detail does not flicker.
+    // Off by default so the statistics and the benchmarks measure the unscaled selection
+    struct FrameTimeController
+    {
+        bool enabled = false;
+
+        float targetMs = 8.3f;   // 120 Hz
+        float deadbandMs = 0.5f; // No correction while the smoothed frame time is this close to the target
+
+        float kp = 0.5f;
+        float ki = 0.05f;
+        float kd = 0.25f;
+        float recovery = 0.5f; // Frames faster than the target correct this much slower, detail is lost before frames are
+
+        float minScale = 0.25f;
+        float maxScale = 16.0f;
+
+        float smoothedMs = 0.0f;
+        float integral = 0.0f;
+        float lastError = 0.0f;
+        float scale = 1.0f; // Multiplies the error thresholds and divides the distance thresholds and the triangle budget
+
+        void update(float frameMs);
+    }; // struct FrameTimeController
+
+    // How the LoD of the scene is selected every frame
+    enum SelectionMode
+    {
+        SELECTION_TRAVERSAL,   // Traverse the DAG from the roots of every visible instance
+        SELECTION_INCREMENTAL, // Keep the cut between frames and re-evaluate a part of it every frame
+        SELECTION_FLAT,        // Test every node on its own against the monotonic error bounds
+        SELECTION_BUDGET,      // Refine the largest errors first until the triangle budget is reached
+    };
+
     struct Camera
     {
         float fov_default = 45.0f;
@@ -53,9 +89,20 @@ namespace lod
         float yaw = 0.0f;
 
         glm::vec3 velocity = glm::vec3(0.0f, 0.0f, 0.0f);
+        glm::vec2 angularVelocity = glm::vec2(0.0f, 0.0f); // The change of the yaw and the pitch in degrees per ms
 
         float pixelThreshold = 0.005f;                                                                          // Min size of a node to check
         float SSEThreshold = 0.75f;                                                                             // The SSE threshold to use for the meshlet
+        float errorThreshold = 1.0f;                                                                            // Projected error in pixels above which the flat cut refines a node
+        uint32_t triangleBudget = 2'000'000;                                                                    // Triangles the budgeted cut may select
+        float cullDistance = std::numeric_limits<float>::infinity();                                            // Instances further away than this are not drawn
+        SelectionMode selection = SELECTION_FLAT;                                                               // How the LoD is selected, see SelectionMode
+        bool distanceThresholds = true;                                                                         // Refine by the distance thresholds instead of the screen space error
+        bool backfaceCulling = true;                                                                            // Test the normal cone of the selected clusters before they take a draw range
+        bool occlusionCulling = true;                                                                           // Test the selected clusters against the coarsest LoD of the nearest meshes
+        bool pipelinedSelection = false;                                                                        // Select the LoD of the next frame while the current one is drawn, from the camera moved and turned ahead
+
+        FrameTimeController frameTime;
         std::vector<float> thresholds = {0.5f, 1.5f, 2.0f, 3.0f, 4.0f, 5.0f, 8.0f, 10.0f, 15.0f, 18.0f, 20.0f}; // Good for the bunny and teapot
 
         glm::vec3 position = glm::vec3(-10.0f, 0.0f, 0.0f);
@@ -96,4 +143,7 @@ namespace lod
 
     void buildFrustum(Camera &cam);
 
+    // The camera ms milliseconds ahead, moved by its velocity and turned by its angular velocity
+    Camera predictCamera(const Camera &cam, float ms);
+
 } // namespace lod
@@ -0,0 +1,230 @@
+// internal includes
+#include "lodCulling.hpp"
+
+// std library includes
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define LOD_CULL_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LOD_CULL_SSE 1
+#endif
+
+namespace lod
+{
+    FrustumPlanes::FrustumPlanes(const Frustum &frustum)
+    {
+        const Plane *source[6] = {&frustum.left, &frustum.right, &frustum.top, &frustum.bottom, &frustum.near, &frustum.far};
+
+        for (int p = 0; p < 6; p++)
+        {
+            nx[p] = source[p]->normal.x;
+            ny[p] = source[p]->normal.y;
+            nz[p] = source[p]->normal.z;
+            d[p] = source[p]->distance;
+        }
+    }
+
+    // A world point is toWorld * x, so n * (A * x + t) + d becomes (A^T * n) * x + (n * t + d)
+    FrustumPlanes::FrustumPlanes(const Frustum &frustum, const glm::mat4 &toWorld) : FrustumPlanes(frustum)
+    {
+        for (int p = 0; p < 6; p++)
+        {
+            const glm::vec3 normal(nx[p], ny[p], nz[p]);
+
+            nx[p] = glm::dot(glm::vec3(toWorld[0]), normal);
+            ny[p] = glm::dot(glm::vec3(toWorld[1]), normal);
+            nz[p] = glm::dot(glm::vec3(toWorld[2]), normal);
+            d[p] += glm::dot(glm::vec3(toWorld[3]), normal);
+        }
+    }
+
+    // The corner furthest along the normal decides if the box is outside, the nearest one if it is inside.
+    // n * max is the larger product for a positive n and the smaller one for a negative n, so a min/max of the two
+    // products picks the same corners as the branches in isAABBInFrustum
+    void cullBounds_scalar(const FrustumPlanes &planes, const BoundsSoA &bounds, const uint32_t *ids, uint32_t count, CullResult *results)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const uint32_t id = ids[i];
+
+            bool outside = false;
+            bool inside = true;
+            for (int p = 0; p < 6; p++)
+            {
+                float x0 = planes.nx[p] * bounds.minX[id], x1 = planes.nx[p] * bounds.maxX[id];
+                float y0 = planes.ny[p] * bounds.minY[id], y1 = planes.ny[p] * bounds.maxY[id];
+                float z0 = planes.nz[p] * bounds.minZ[id], z1 = planes.nz[p] * bounds.maxZ[id];
+
+                float positive = std::max(x0, x1) + std::max(y0, y1) + std::max(z0, z1) + planes.d[p];
+                float negative = std::min(x0, x1) + std::min(y0, y1) + std::min(z0, z1) + planes.d[p];
+
+                outside |= positive < 0.0f;
+                inside &= negative >= 0.0f;
+            }
+
+            results[i] = outside ? CULL_OUTSIDE : (inside ? CULL_INSIDE : CULL_INTERSECTING);
+        }
+    }
+
+#if LOD_CULL_AVX2
+    void cullBounds(const FrustumPlanes &planes, const BoundsSoA &bounds, const uint32_t *ids, uint32_t count, CullResult *results)
+    {
+        for (uint32_t i = 0; i < count; i += 8)
+        {
+            // The last batch repeats the last box
+            alignas(32) int32_t lanes[8];
+            for (uint32_t l = 0; l < 8; l++)
+            {
+                lanes[l] = int32_t(ids[std::min(i + l, count - 1)]);
+            }
+            const __m256i index = _mm256_load_si256(reinterpret_cast<const __m256i *>(lanes));
+
+            const __m256 minX = _mm256_i32gather_ps(bounds.minX.data(), index, 4);
+            const __m256 minY = _mm256_i32gather_ps(bounds.minY.data(), index, 4);
+            const __m256 minZ = _mm256_i32gather_ps(bounds.minZ.data(), index, 4);
+            const __m256 maxX = _mm256_i32gather_ps(bounds.maxX.data(), index, 4);
+            const __m256 maxY = _mm256_i32gather_ps(bounds.maxY.data(), index, 4);
+            const __m256 maxZ = _mm256_i32gather_ps(bounds.maxZ.data(), index, 4);
+
+            __m256 outside = _mm256_setzero_ps();
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            const __m256 zero = _mm256_setzero_ps();
+
+            for (int p = 0; p < 6; p++)
+            {
+                const __m256 nx = _mm256_set1_ps(planes.nx[p]);
+                const __m256 ny = _mm256_set1_ps(planes.ny[p]);
+                const __m256 nz = _mm256_set1_ps(planes.nz[p]);
+                const __m256 d = _mm256_set1_ps(planes.d[p]);
+
+                __m256 x0 = _mm256_mul_ps(nx, minX), x1 = _mm256_mul_ps(nx, maxX);
+                __m256 y0 = _mm256_mul_ps(ny, minY), y1 = _mm256_mul_ps(ny, maxY);
+                __m256 z0 = _mm256_mul_ps(nz, minZ), z1 = _mm256_mul_ps(nz, maxZ);
+
+                __m256 positive = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_max_ps(x0, x1), _mm256_max_ps(y0, y1)), _mm256_max_ps(z0, z1)), d);
+                __m256 negative = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_min_ps(x0, x1), _mm256_min_ps(y0, y1)), _mm256_min_ps(z0, z1)), d);
+
+                outside = _mm256_or_ps(outside, _mm256_cmp_ps(positive, zero, _CMP_LT_OQ));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(negative, zero, _CMP_GE_OQ));
+            }
+
+            const int outsideMask = _mm256_movemask_ps(outside);
+            const int insideMask = _mm256_movemask_ps(inside);
+
+            for (uint32_t l = 0; l < 8 && i + l < count; l++)
+            {
+                results[i + l] = ((outsideMask >> l) & 1) ? CULL_OUTSIDE : (((insideMask >> l) & 1) ? CULL_INSIDE : CULL_INTERSECTING);
+            }
+        }
+    }
+
+    const char *cullBoundsKernel() { return "AVX2"; }
+#elif LOD_CULL_SSE
+    void cullBounds(const FrustumPlanes &planes, const BoundsSoA &bounds, const uint32_t *ids, uint32_t count, CullResult *results)
+    {
+        for (uint32_t i = 0; i < count; i += 4)
+        {
+            // The last batch repeats the last box
+            uint32_t lanes[4];
+            for (uint32_t l = 0; l < 4; l++)
+            {
+                lanes[l] = ids[std::min(i + l, count - 1)];
+            }
+
+            const __m128 minX = _mm_setr_ps(bounds.minX[lanes[0]], bounds.minX[lanes[1]], bounds.minX[lanes[2]], bounds.minX[lanes[3]]);
+            const __m128 minY = _mm_setr_ps(bounds.minY[lanes[0]], bounds.minY[lanes[1]], bounds.minY[lanes[2]], bounds.minY[lanes[3]]);
+            const __m128 minZ = _mm_setr_ps(bounds.minZ[lanes[0]], bounds.minZ[lanes[1]], bounds.minZ[lanes[2]], bounds.minZ[lanes[3]]);
+            const __m128 maxX = _mm_setr_ps(bounds.maxX[lanes[0]], bounds.maxX[lanes[1]], bounds.maxX[lanes[2]], bounds.maxX[lanes[3]]);
+            const __m128 maxY = _mm_setr_ps(bounds.maxY[lanes[0]], bounds.maxY[lanes[1]], bounds.maxY[lanes[2]], bounds.maxY[lanes[3]]);
+            const __m128 maxZ = _mm_setr_ps(bounds.maxZ[lanes[0]], bounds.maxZ[lanes[1]], bounds.maxZ[lanes[2]], bounds.maxZ[lanes[3]]);
+
+            __m128 outside = _mm_setzero_ps();
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            const __m128 zero = _mm_setzero_ps();
+
+            for (int p = 0; p < 6; p++)
+            {
+                const __m128 nx = _mm_set1_ps(planes.nx[p]);
+                const __m128 ny = _mm_set1_ps(planes.ny[p]);
+                const __m128 nz = _mm_set1_ps(planes.nz[p]);
+                const __m128 d = _mm_set1_ps(planes.d[p]);
+
+                __m128 x0 = _mm_mul_ps(nx, minX), x1 = _mm_mul_ps(nx, maxX);
+                __m128 y0 = _mm_mul_ps(ny, minY), y1 = _mm_mul_ps(ny, maxY);
+                __m128 z0 = _mm_mul_ps(nz, minZ), z1 = _mm_mul_ps(nz, maxZ);
+
+                __m128 positive = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_max_ps(x0, x1), _mm_max_ps(y0, y1)), _mm_max_ps(z0, z1)), d);
+                __m128 negative = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_min_ps(x0, x1), _mm_min_ps(y0, y1)), _mm_min_ps(z0, z1)), d);
+
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(positive, zero));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(negative, zero));
+            }
+
+            const int outsideMask = _mm_movemask_ps(outside);
+            const int insideMask = _mm_movemask_ps(inside);
+
+            for (uint32_t l = 0; l < 4 && i + l < count; l++)
+            {
+                results[i + l] = ((outsideMask >> l) & 1) ? CULL_OUTSIDE : (((insideMask >> l) & 1) ? CULL_INSIDE : CULL_INTERSECTING);
+            }
+        }
+    }
+
+    const char *cullBoundsKernel() { return "SSE"; }
+#else
+    void cullBounds(const FrustumPlanes &planes, const BoundsSoA &bounds, const uint32_t *ids, uint32_t count, CullResult *results)
+    {
+        cullBounds_scalar(planes, bounds, ids, count, results);
+    }
+
+    const char *cullBoundsKernel() { return "scalar"; }
+#endif
+
+    bool isBackfacing(const glm::vec4 &cone, const BoundingBox &bb, const glm::vec3 &eye)
+    {
+        if (cone.w >= 0.0f)
+        {
+            return false;
+        }
+
+        const glm::vec3 axis = glm::vec3(cone);
+
+        for (int n = 0; n < 8; n++)
+        {
+            glm::vec3 corner((n & 1) ? bb.maxPoint.x : bb.minPoint.x, (n & 2) ? bb.maxPoint.y : bb.minPoint.y, (n & 4) ? bb.maxPoint.z : bb.minPoint.z);
+            glm::vec3 direction = eye - corner;
+
+            // dot(axis, normalize(direction)) < cone.w without the division
+            if (glm::dot(axis, direction) >= cone.w * glm::length(direction))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Every axis of the new box gets the smaller and the larger product of each column with the old box (Arvo)
+    BoundingBox transformBounds(const BoundingBox &bb, const glm::mat4 &toWorld)
+    {
+        BoundingBox result;
+        result.minPoint = glm::vec3(toWorld[3]);
+        result.maxPoint = glm::vec3(toWorld[3]);
+
+        for (int column = 0; column < 3; column++)
+        {
+            const glm::vec3 axis(toWorld[column]);
+            const glm::vec3 a = axis * bb.minPoint[column];
+            const glm::vec3 b = axis * bb.maxPoint[column];
+
+            result.minPoint += glm::min(a, b);
+            result.maxPoint += glm::max(a, b);
+        }
+
+        return result;
+    }
+
+} // namespace lod
@@ -0,0 +1,50 @@
+#pragma once
+
+// Internal includes
+#include "lodCamera.hpp"
+#include "lodGeometry.hpp"
+
+// Std library includes
+#include <cstdint>
+
+namespace lod
+{
+    enum CullResult : uint8_t
+    {
+        CULL_OUTSIDE = 0,      // Completely behind one of the planes
+        CULL_INTERSECTING = 1, // Visible but crossing at least one plane
+        CULL_INSIDE = 2,       // Completely inside, the children do not need to be tested again
+    };
+
+    // The six frustum planes as one array per component, built once per traversal
+    struct FrustumPlanes
+    {
+        float nx[6];
+        float ny[6];
+        float nz[6];
+        float d[6];
+
+        FrustumPlanes() = default;
+        FrustumPlanes(const Frustum &frustum);
+        // The planes in the model space of an instance, so its boxes can be tested without moving them to world space
+        FrustumPlanes(const Frustum &frustum, const glm::mat4 &toWorld);
+    }; // struct FrustumPlanes
+
+    // Tests the boxes bounds[ids[0 .. count - 1]] against all six planes and writes one CullResult per box
+    // Uses AVX2 when the compiler targets it (8 boxes per step), SSE otherwise (4 boxes per step)
+    void cullBounds(const FrustumPlanes &planes, const BoundsSoA &bounds, const uint32_t *ids, uint32_t count, CullResult *results);
+
+    // One box at a time, the reference the vector kernels have to agree with
+    void cullBounds_scalar(const FrustumPlanes &planes, const BoundsSoA &bounds, const uint32_t *ids, uint32_t count, CullResult *results);
+
+    // Name of the kernel cullBounds was compiled with
+    const char *cullBoundsKernel();
+
+    // The normal cone test of the task shader, true when the eye is behind the cone seen from every corner of the box
+    // cone.xyz is the axis and cone.w is -sin(cone angle), a w >= 0 can never face away
+    bool isBackfacing(const glm::vec4 &cone, const BoundingBox &bb, const glm::vec3 &eye);
+
+    // The world space AABB of a model space box moved by toWorld, it encloses the moved box but can be larger
+    BoundingBox transformBounds(const BoundingBox &bb, const glm::mat4 &toWorld);
+
+} // namespace lod
@@ -9,6 +9,10 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <queue>
+#include <thread>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
 
 // GEL library includes
 #include <GEL/HMesh/HMesh.h>
@@ -812,5 +816,549 @@ namespace lod
 
 namespace lod
 {
+    void Graph::DAG::indexMeshes()
+    {
+        if (meshIndices.size() != size())
+        {
+            throw std::runtime_error("Every DAG node needs the index of its mesh");
+        }
+
+        meshCount = meshIndices.empty() ? 0 : *std::max_element(meshIndices.begin(), meshIndices.end()) + 1;
+        meshLevelBegin.assign(size_t(levels()) * meshCount + 1, 0);
+
+        for (uint32_t node = 0; node < size(); node++)
+        {
+            if ((node > levelBegin[lods[node]]) && (meshIndices[node - 1] > meshIndices[node]))
+            {
+                throw std::runtime_error("The nodes of every LoD of the DAG have to be sorted by mesh");
+            }
+
+            meshLevelBegin[size_t(lods[node]) * meshCount + meshIndices[node] + 1]++;
+        }
+
+        for (size_t range = 1; range < meshLevelBegin.size(); range++)
+        {
+            meshLevelBegin[range] += meshLevelBegin[range - 1];
+        }
+
+        // The LoDs go up one after the other, so a mesh counts its nodes LoD by LoD
+        std::vector<uint32_t> counted(meshCount, 0);
+        meshNodes.resize(size());
+        for (uint32_t node = 0; node < size(); node++)
+        {
+            meshNodes[node] = counted[meshIndices[node]]++;
+        }
+    }
+
+    // The children of one mesh on one LoD bucketed into a uniform grid over their extent, the cells are about the size of
+    // an average child
+    struct ChildGrid
+    {
+        glm::vec3 origin = glm::vec3(0.0f);
+        glm::vec3 invCell = glm::vec3(0.0f);
+        glm::ivec3 res = glm::ivec3(0);
+        std::vector<uint32_t> cellBegin;
+        std::vector<uint32_t> cellChildren;
+
+        void cellRange(const BoundingBox &bb, glm::ivec3 &cellMin, glm::ivec3 &cellMax) const
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                cellMin[axis] = std::clamp(int(std::floor((bb.minPoint[axis] - origin[axis]) * invCell[axis])), 0, res[axis] - 1);
+                cellMax[axis] = std::clamp(int(std::floor((bb.maxPoint[axis] - origin[axis]) * invCell[axis])), 0, res[axis] - 1);
+            }
+        }
+
+        uint32_t cell(int x, int y, int z) const { return (uint32_t(z) * res.y + uint32_t(y)) * res.x + uint32_t(x); }
+    };
+
+    // Buckets the children [first, last) into every cell they touch, counted first so the buckets are one array
+    static void buildChildGrid(const Graph::DAG &dag, uint32_t first, uint32_t last, ChildGrid &grid)
+    {
+        const uint32_t childCount = last - first;
+        if (childCount == 0)
+        {
+            return;
+        }
+
+        BoundingBox extent = dag.bounds[first];
+        glm::vec3 averageSize = glm::vec3(0.0f);
+        for (uint32_t child = first; child < last; child++)
+        {
+            BoundingBox bb = dag.bounds[child];
+            extent.minPoint = glm::min(extent.minPoint, bb.minPoint);
+            extent.maxPoint = glm::max(extent.maxPoint, bb.maxPoint);
+            averageSize += bb.maxPoint - bb.minPoint;
+        }
+        averageSize /= float(childCount);
+
+        // Cap the resolution so that the grid never has many more cells than children
+        const int maxRes = std::max(1, 2 * int(std::cbrt(double(childCount))));
+        const glm::vec3 size = extent.maxPoint - extent.minPoint;
+
+        grid.origin = extent.minPoint;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            grid.res[axis] = (averageSize[axis] > 0.0f) ? std::clamp(int(size[axis] / averageSize[axis]), 1, maxRes) : 1;
+            grid.invCell[axis] = (size[axis] > 0.0f) ? float(grid.res[axis]) / size[axis] : 0.0f;
+        }
+
+        const uint32_t numCells = uint32_t(grid.res.x) * grid.res.y * grid.res.z;
+        grid.cellBegin.assign(numCells + 1, 0);
+
+        for (int pass = 0; pass < 2; pass++)
+        {
+            if (pass == 1)
+            {
+                for (uint32_t cell = 0; cell < numCells; cell++)
+                {
+                    grid.cellBegin[cell + 1] += grid.cellBegin[cell];
+                }
+                grid.cellChildren.resize(grid.cellBegin[numCells]);
+            }
+
+            std::vector<uint32_t> fill(grid.cellBegin.begin(), grid.cellBegin.end() - 1);
+
+            for (uint32_t child = first; child < last; child++)
+            {
+                glm::ivec3 cellMin;
+                glm::ivec3 cellMax;
+                grid.cellRange(dag.bounds[child], cellMin, cellMax);
+
+                for (int z = cellMin.z; z <= cellMax.z; z++)
+                {
+                    for (int y = cellMin.y; y <= cellMax.y; y++)
+                    {
+                        for (int x = cellMin.x; x <= cellMax.x; x++)
+                        {
+                            if (pass == 0)
+                            {
+                                grid.cellBegin[grid.cell(x, y, z) + 1]++;
+                            }
+                            else
+                            {
+                                grid.cellChildren[fill[grid.cell(x, y, z)]++] = child;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Overlapping children of the parents [first, last) of one LoD, found through the grid of the mesh of every parent
+    static void linkChildren_task(const Graph::DAG &dag, uint32_t first, uint32_t last, uint32_t childFirst, const std::vector<ChildGrid> &grids,
+                                  std::vector<std::vector<uint32_t>> &nodeChildren)
+    {
+        std::vector<uint32_t> stamp(dag.levelSize(dag.lods[childFirst]), ~0u); // The last parent that collected the child, avoids duplicates from children spanning cells
+        std::vector<uint32_t> candidates;
+
+        for (uint32_t parent = first; parent < last; parent++)
+        {
+            const BoundingBox &parent_bb = dag.bounds[parent];
+            const ChildGrid &grid = grids[dag.meshIndices[parent]];
+
+            if (grid.cellChildren.empty())
+            {
+                continue;
+            }
+
+            glm::ivec3 cellMin;
+            glm::ivec3 cellMax;
+            grid.cellRange(parent_bb, cellMin, cellMax);
+
+            candidates.clear();
+            for (int z = cellMin.z; z <= cellMax.z; z++)
+            {
+                for (int y = cellMin.y; y <= cellMax.y; y++)
+                {
+                    for (int x = cellMin.x; x <= cellMax.x; x++)
+                    {
+                        uint32_t cell = grid.cell(x, y, z);
+                        for (uint32_t c = grid.cellBegin[cell]; c < grid.cellBegin[cell + 1]; c++)
+                        {
+                            uint32_t child = grid.cellChildren[c];
+                            if (stamp[child - childFirst] != parent)
+                            {
+                                stamp[child - childFirst] = parent;
+                                candidates.push_back(child);
+                            }
+                        }
+                    }
+                }
+            }
+
+            // Same order as the all-pairs scan
+            std::sort(candidates.begin(), candidates.end());
+
+            std::vector<uint32_t> &children = nodeChildren[parent];
+            for (uint32_t child : candidates)
+            {
+                if (parent_bb.isContained(parent_bb, dag.bounds[child]))
+                {
+                    children.push_back(child);
+                }
+            }
+        }
+    }
+
+    void Graph::DAG::linkChildren(unsigned int numThreads)
+    {
+        numThreads = std::max(numThreads, 1u);
+
+        std::vector<std::vector<uint32_t>> nodeChildren(size());
+        std::vector<ChildGrid> grids;
+
+        for (int lod = 1; lod < int(levels()); lod++)
+        {
+            const uint32_t childFirst = levelBegin[lod - 1];
+
+            if ((levelSize(lod - 1) == 0) || (levelSize(lod) == 0))
+            {
+                continue;
+            }
+
+            // Children of other meshes overlap as well when the meshes do, every mesh gets its own grid
+            grids.assign(meshCount, ChildGrid());
+            for (uint32_t mesh = 0; mesh < meshCount; mesh++)
+            {
+                buildChildGrid(*this, meshLevelFirst(mesh, lod - 1), meshLevelEnd(mesh, lod - 1), grids[mesh]);
+            }
+
+            // Link the parents of this LoD in parallel, every thread writes to its own parents only
+            const uint32_t first = levelBegin[lod];
+            const uint32_t count = levelSize(lod);
+            const uint32_t threadCount = std::min(numThreads, count);
+
+            std::vector<std::thread> threads;
+            for (uint32_t t = 0; t < threadCount; t++)
+            {
+                uint32_t begin = first + uint32_t((uint64_t(count) * t) / threadCount);
+                uint32_t end = first + uint32_t((uint64_t(count) * (t + 1)) / threadCount);
+
+                threads.emplace_back(linkChildren_task, std::cref(*this), begin, end, childFirst, std::cref(grids), std::ref(nodeChildren));
+            }
+
+            for (auto &thread : threads)
+            {
+                thread.join();
+            }
+        }
+
+        childBegin.assign(1, 0);
+        children.clear();
+        for (uint32_t node = 0; node < size(); node++)
+        {
+            children.insert(children.end(), nodeChildren[node].begin(), nodeChildren[node].end());
+            childBegin.push_back(uint32_t(children.size()));
+        }
+
+        linkParents();
+    }
+
+    void Graph::DAG::linkChildrenAllPairs()
+    {
+        childBegin.assign(1, 0);
+        children.clear();
+
+        for (uint32_t parent = 0; parent < size(); parent++)
+        {
+            int lod = lods[parent];
+            if (lod > 0)
+            {
+                const BoundingBox &parent_bb = bounds[parent];
+                const uint32_t mesh = meshIndices[parent];
+
+                // Check the lower level of the same mesh
+                for (uint32_t child = meshLevelFirst(mesh, lod - 1); child < meshLevelEnd(mesh, lod - 1); child++)
+                {
+                    if (parent_bb.isContained(parent_bb, bounds[child]))
+                    {
+                        children.push_back(child);
+                    }
+                }
+            }
+
+            childBegin.push_back(uint32_t(children.size()));
+        }
+
+        linkParents();
+    }
+
+    void Graph::DAG::linkParents()
+    {
+        parentBegin.assign(size() + 1, 0);
+        for (uint32_t child : children)
+        {
+            parentBegin[child + 1]++;
+        }
+        for (uint32_t node = 0; node < size(); node++)
+        {
+            parentBegin[node + 1] += parentBegin[node];
+        }
+
+        // Parents are visited in increasing order so every list ends up sorted
+        parents.resize(children.size());
+        std::vector<uint32_t> fill(parentBegin.begin(), parentBegin.end() - 1);
+        for (uint32_t parent = 0; parent < size(); parent++)
+        {
+            for (uint32_t c = childBegin[parent]; c < childBegin[parent + 1]; c++)
+            {
+                parents[fill[children[c]]++] = parent;
+            }
+        }
+    }
+
+    // Closest point on the triangle abc to p, from Real-Time Collision Detection 5.1.5
+    static glm::vec3 closestPointOnTriangle(const glm::vec3 &p, const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c)
+    {
+        glm::vec3 ab = b - a;
+        glm::vec3 ac = c - a;
+        glm::vec3 ap = p - a;
+
+        float d1 = glm::dot(ab, ap);
+        float d2 = glm::dot(ac, ap);
+        if (d1 <= 0.0f && d2 <= 0.0f)
+        {
+            return a;
+        }
+
+        glm::vec3 bp = p - b;
+        float d3 = glm::dot(ab, bp);
+        float d4 = glm::dot(ac, bp);
+        if (d3 >= 0.0f && d4 <= d3)
+        {
+            return b;
+        }
+
+        float vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        {
+            return a + ab * (d1 / (d1 - d3));
+        }
+
+        glm::vec3 cp = p - c;
+        float d5 = glm::dot(ab, cp);
+        float d6 = glm::dot(ac, cp);
+        if (d6 >= 0.0f && d5 <= d6)
+        {
+            return c;
+        }
+
+        float vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        {
+            return a + ac * (d2 / (d2 - d6));
+        }
+
+        float va = d3 * d6 - d5 * d4;
+        if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+        {
+            return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+        }
+
+        float denom = 1.0f / (va + vb + vc);
+        return a + ab * (vb * denom) + ac * (vc * denom);
+    }
+
+    // Distance from p to the nearest triangle of the meshlets, a meshlet whose AABB is further away than the best
+    // distance so far is skipped
+    static float distanceToSurface(const glm::vec3 &p, const std::vector<const Meshlet *> &surface)
+    {
+        float best = FLT_MAX;
+
+        for (const Meshlet *meshlet : surface)
+        {
+            glm::vec3 outside = glm::max(meshlet->minPoint - p, glm::max(p - meshlet->maxPoint, glm::vec3(0.0f)));
+            if (glm::dot(outside, outside) >= best * best)
+            {
+                continue;
+            }
+
+            for (size_t i = 0; i + 2 < meshlet->indices.size(); i += 3)
+            {
+                glm::vec3 closest = closestPointOnTriangle(p, meshlet->vertices[meshlet->indices[i]].pos, meshlet->vertices[meshlet->indices[i + 1]].pos,
+                                                           meshlet->vertices[meshlet->indices[i + 2]].pos);
+                best = std::min(best, glm::length(p - closest));
+            }
+        }
+
+        return best;
+    }
+
+    // How often a triangle is split in four while its distance bound is looser than the bound of the node
+    static const int HAUSDORFF_SPLITS = 4;
+
+    // Raises bound to an upper bound of the distance from every point of the triangle to the surface. The distance is
+    // 1-Lipschitz and the triangle lies within the sphere around its centroid through the farthest corner, so the
+    // distance at the centroid plus that radius holds for the whole triangle. Triangles whose bound is above the
+    // current one are split until HAUSDORFF_SPLITS, the last split keeps its bound
+    static float boundTriangleDistance(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c, const std::vector<const Meshlet *> &surface, float bound, int splits)
+    {
+        glm::vec3 center = (a + b + c) / 3.0f;
+        float radius = std::sqrt(std::max(glm::dot(a - center, a - center), std::max(glm::dot(b - center, b - center), glm::dot(c - center, c - center))));
+        float distance = distanceToSurface(center, surface);
+
+        if (distance + radius <= bound)
+        {
+            return bound;
+        }
+        if (splits == 0)
+        {
+            return distance + radius;
+        }
+
+        glm::vec3 ab = (a + b) * 0.5f;
+        glm::vec3 bc = (b + c) * 0.5f;
+        glm::vec3 ca = (c + a) * 0.5f;
+
+        bound = std::max(bound, distance);
+        bound = boundTriangleDistance(a, ab, ca, surface, bound, splits - 1);
+        bound = boundTriangleDistance(ab, b, bc, surface, bound, splits - 1);
+        bound = boundTriangleDistance(ca, bc, c, surface, bound, splits - 1);
+        bound = boundTriangleDistance(ab, bc, ca, surface, bound, splits - 1);
+        return bound;
+    }
+
+    // Error of the nodes [first, last) of one LoD, the children have already been measured
+    static void measureErrors_task(Graph::DAG &dag, const std::vector<const Meshlet *> &meshlets, uint32_t first, uint32_t last)
+    {
+        std::vector<const Meshlet *> surface;
+
+        for (uint32_t node = first; node < last; node++)
+        {
+            if (dag.childCount(node) == 0)
+            {
+                dag.errors[node] = 0.0f;
+                continue;
+            }
+
+            // The fine surface this node replaces, the children are all of the same mesh
+            surface.clear();
+            float childError = 0.0f;
+            for (uint32_t c = dag.childBegin[node]; c < dag.childBegin[node + 1]; c++)
+            {
+                uint32_t child = dag.children[c];
+                surface.push_back(meshlets[child]);
+                childError = std::max(childError, dag.errors[child]);
+            }
+
+            // One sided Hausdorff distance of this node to the surface of its children. Samples at the vertices only give
+            // a lower bound, the triangles raise it to an upper bound so that the errors stay conservative
+            const Meshlet &coarse = *meshlets[node];
+            float hausdorff = 0.0f;
+
+            for (const mm::Vertex &vertex : coarse.vertices)
+            {
+                hausdorff = std::max(hausdorff, distanceToSurface(vertex.pos, surface));
+            }
+
+            // A surface without triangles has nothing to measure against
+            if (hausdorff == FLT_MAX)
+            {
+                hausdorff = 0.0f;
+            }
+            else
+            {
+                for (size_t i = 0; i + 2 < coarse.indices.size(); i += 3)
+                {
+                    hausdorff = boundTriangleDistance(coarse.vertices[coarse.indices[i]].pos, coarse.vertices[coarse.indices[i + 1]].pos,
+                                                      coarse.vertices[coarse.indices[i + 2]].pos, surface, hausdorff, HAUSDORFF_SPLITS);
+                }
+            }
+
+            // The children are themselves this far from the original surface
+            dag.errors[node] = hausdorff + childError;
+        }
+    }
+
+    void Graph::DAG::measureErrors(const std::vector<const Meshlet *> &meshlets, unsigned int numThreads)
+    {
+        numThreads = std::max(numThreads, 1u);
+
+        // A LoD needs the errors of the LoD below so the levels go one after the other
+        for (uint32_t lod = 0; lod < levels(); lod++)
+        {
+            const uint32_t first = levelBegin[lod];
+            const uint32_t count = levelSize(lod);
+            const uint32_t threadCount = std::min(numThreads, count);
+
+            std::vector<std::thread> threads;
+            for (uint32_t t = 0; t < threadCount; t++)
+            {
+                uint32_t begin = first + uint32_t((uint64_t(count) * t) / threadCount);
+                uint32_t end = first + uint32_t((uint64_t(count) * (t + 1)) / threadCount);
+
+                threads.emplace_back(measureErrors_task, std::ref(*this), std::cref(meshlets), begin, end);
+            }
+
+            for (auto &thread : threads)
+            {
+                thread.join();
+            }
+        }
+    }
+
+    // The smallest sphere around both spheres
+    static glm::vec4 encloseSpheres(const glm::vec4 &a, const glm::vec4 &b)
+    {
+        glm::vec3 offset = glm::vec3(b) - glm::vec3(a);
+        float distance = glm::length(offset);
+
+        if (distance + b.w <= a.w)
+        {
+            return a;
+        }
+        if (distance + a.w <= b.w)
+        {
+            return b;
+        }
+
+        float radius = (distance + a.w + b.w) * 0.5f;
+        glm::vec3 center = glm::vec3(a) + offset * ((radius - a.w) / distance);
+        return glm::vec4(center, radius);
+    }
+
+    void Graph::DAG::buildErrorBounds()
+    {
+        errorSpheres.resize(size());
+        for (uint32_t node = 0; node < size(); node++)
+        {
+            BoundingBox bb = bounds[node];
+            errorSpheres[node] = glm::vec4((bb.minPoint + bb.maxPoint) * 0.5f, glm::length(bb.maxPoint - bb.minPoint) * 0.5f);
+        }
+
+        // Children always sit on the LoD below so going through the ids in order visits them first
+        for (uint32_t node = 0; node < size(); node++)
+        {
+            for (uint32_t c = childBegin[node]; c < childBegin[node + 1]; c++)
+            {
+                uint32_t child = children[c];
+                errors[node] = std::max(errors[node], errors[child]);
+                errorSpheres[node] = encloseSpheres(errorSpheres[node], errorSpheres[child]);
+            }
+        }
+
+        parentErrors.assign(size(), FLT_MAX);
+        parentSpheres.resize(size());
+        for (uint32_t node = 0; node < size(); node++)
+        {
+            if (parentCount(node) == 0)
+            {
+                parentSpheres[node] = errorSpheres[node];
+                continue;
+            }
+
+            uint32_t first = parents[parentBegin[node]];
+            parentErrors[node] = errors[first];
+            parentSpheres[node] = errorSpheres[first];
+
+            for (uint32_t p = parentBegin[node] + 1; p < parentBegin[node + 1]; p++)
+            {
+                parentErrors[node] = std::max(parentErrors[node], errors[parents[p]]);
+                parentSpheres[node] = encloseSpheres(parentSpheres[node], errorSpheres[parents[p]]);
+            }
+        }
+    }
 
 } // namespace LOD: The code for the Graphs
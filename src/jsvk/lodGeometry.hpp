@@ -90,6 +90,9 @@ namespace lod
         // The center of the meshlet
         glm::vec3 center = glm::vec3(0.0f);
 
+        // The normal cone decoded from the meshlet descriptor, xyz axis and w -sin(cone angle), w >= 0 is never backfacing
+        glm::vec4 cone = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
         // int id = 0;
 
         // TODO: this should be calculated using the bb or something else
@@ -129,6 +132,9 @@ namespace lod
         std::vector<mm::MeshletCache<uint32_t>> meshletCache{};
         std::vector<mm::Triangle *> triangles;
         std::vector<NVMeshlet::Stats> stats;
+        std::vector<NVMeshlet::Stats> unmergedStats; // Stats before underfilled meshlets were merged, empty if they were not
+        size_t fittedPrimitiveBytes = 0;             // Size of the uint8 primitive indices before they were packed as strips
+        uint64_t geometryHash = 0;                   // Content hash of the packed meshlets and vertices, used to share uploads
         std::vector<ObjectData> objectData;
         NVMeshlet::Builder<uint32_t>::MeshletGeometry packedMeshlets;
 
@@ -143,6 +149,7 @@ namespace lod
         std::vector<uint32_t> vbo_offsets{};
 
         std::vector<uint32_t> desc_counts{};
+        std::vector<int> sharedGeometry{}; // -1 if the geometry is uploaded, otherwise the index of the identical geometry it reuses
 
         std::vector<int> no_triangles{};
 
@@ -176,7 +183,7 @@ namespace lod
         glm::vec3 minPoint = glm::vec3(0.0f);
         glm::vec3 maxPoint = glm::vec3(0.0f);
 
-        bool isContained(const BoundingBox &parent, const BoundingBox &child)
+        bool isContained(const BoundingBox &parent, const BoundingBox &child) const
         {
             // Check if any part of the child's bounding box is inside or touching the parent's bounding box.
             return !(child.maxPoint.x < parent.minPoint.x || child.minPoint.x > parent.maxPoint.x ||
@@ -187,43 +194,185 @@ namespace lod
             return (parent.minPoint.x <= child.minPoint.x && parent.minPoint.y <= child.minPoint.y && parent.minPoint.z <= child.minPoint.z) &&
                    (parent.maxPoint.x >= child.maxPoint.x && parent.maxPoint.y >= child.maxPoint.y && parent.maxPoint.z >= child.maxPoint.z);
         }
+
+        // True if the other box lies completely within this one
+        bool contains(const BoundingBox &other) const
+        {
+            return minPoint.x <= other.minPoint.x && minPoint.y <= other.minPoint.y && minPoint.z <= other.minPoint.z &&
+                   maxPoint.x >= other.maxPoint.x && maxPoint.y >= other.maxPoint.y && maxPoint.z >= other.maxPoint.z;
+        }
     }; // struct BoundingBox
 
-    class Graph
+    // Bounds stored as one array per component so that the culling kernels can load several boxes at once
+    struct BoundsSoA
     {
-    public:
-        struct Node
-        {
-            int lod; // The level of detail of the meshlet (0 is the highest level of detail)
-            uint16_t id;
-            int meshIndex = 0;    // This is the index of the game object from the list of meshes
-            int meshletIndex = 0; // This is the index of the meshlet from the LoD offset
+        std::vector<float> minX, minY, minZ;
+        std::vector<float> maxX, maxY, maxZ;
 
-            std::unordered_map<uint16_t, Node *> children;
+        size_t size() const { return minX.size(); }
 
-            // The AABB of the meshlet
-            std::vector<mm::Vertex> vertices{};
+        BoundingBox operator[](size_t i) const
+        {
             BoundingBox bb;
+            bb.minPoint = glm::vec3(minX[i], minY[i], minZ[i]);
+            bb.maxPoint = glm::vec3(maxX[i], maxY[i], maxZ[i]);
+            return bb;
+        }
 
-            glm::vec3 center = glm::vec3(0.0f); // Used to calculate distance
+        void push_back(const BoundingBox &bb)
+        {
+            minX.push_back(bb.minPoint.x);
+            minY.push_back(bb.minPoint.y);
+            minZ.push_back(bb.minPoint.z);
+            maxX.push_back(bb.maxPoint.x);
+            maxY.push_back(bb.maxPoint.y);
+            maxZ.push_back(bb.maxPoint.z);
+        }
 
-            int no_triangles = 0;
-        }; // struct Node
+        void set(size_t i, const BoundingBox &bb)
+        {
+            minX[i] = bb.minPoint.x;
+            minY[i] = bb.minPoint.y;
+            minZ[i] = bb.minPoint.z;
+            maxX[i] = bb.maxPoint.x;
+            maxY[i] = bb.maxPoint.y;
+            maxZ[i] = bb.maxPoint.z;
+        }
 
+        void clear()
+        {
+            for (auto *component : {&minX, &minY, &minZ, &maxX, &maxY, &maxZ})
+            {
+                component->clear();
+            }
+        }
+    }; // struct BoundsSoA
+
+    class Graph
+    {
+    public:
+        // The DAG is stored flat, nodes are numbered level by level starting at LoD 0 so each LoD is a contiguous
+        // range of ids and every per node attribute lives in its own array indexed by the 32-bit id
         struct DAG
         {
-            // The roots are at nodes[MAX_LOD] and have directions all the way to LoD 0 however this approach is memory intensive
-            std::unordered_map<int, std::vector<lod::Graph::Node>> nodes; // This is the LOD, node mapping
-        };                                                                // struct Graph
+            std::vector<uint32_t> levelBegin{0}; // The nodes of LoD l are [levelBegin[l], levelBegin[l + 1]), the roots are the MAX_LOD level
+
+            // The nodes of every LoD are sorted by mesh, the nodes of mesh m on LoD l are
+            // [meshLevelBegin[l * meshCount + m], meshLevelBegin[l * meshCount + m + 1]). Filled in by indexMeshes
+            uint32_t meshCount = 0;
+            std::vector<uint32_t> meshLevelBegin{0};
+            std::vector<uint32_t> meshNodes; // The index of every node among the nodes of its mesh, for per instance state
+
+            // Hot data read by the traversal
+            BoundsSoA bounds;                // The AABB of the meshlet
+            std::vector<glm::vec3> centers;  // Used to calculate distance
+            std::vector<float> errors;       // The world space error of the node to the original surface
+            std::vector<uint8_t> lods;       // The level of detail of the meshlet (0 is the highest level of detail)
+            std::vector<glm::vec4> cones;    // The normal cone of the meshlet, see lod::isBackfacing
+
+            // The children of node n are children[childBegin[n] .. childBegin[n + 1]), all of them are on the LoD below
+            std::vector<uint32_t> childBegin{0};
+            std::vector<uint32_t> children;
+
+            // The same edges the other way, the parents of node n are parents[parentBegin[n] .. parentBegin[n + 1])
+            std::vector<uint32_t> parentBegin{0};
+            std::vector<uint32_t> parents;
+
+            // Error bounds for selecting the cut without a traversal, filled in by buildErrorBounds once the DAG is linked.
+            // Errors and spheres only grow going up so a node and its parents can be tested on their own
+            std::vector<glm::vec4> errorSpheres;  // xyz center and w radius, encloses the error spheres of the children
+            std::vector<float> parentErrors;      // The largest error of the parents, FLT_MAX for the roots
+            std::vector<glm::vec4> parentSpheres; // Encloses the error spheres of all the parents
+
+            // Cold data only needed once a node is drawn
+            std::vector<uint32_t> meshIndices;    // This is the index of the game object from the list of meshes
+            std::vector<uint32_t> meshletIndices; // This is the index of the meshlet from the LoD offset
+            std::vector<uint32_t> triangleCounts;
+
+            uint32_t size() const { return uint32_t(lods.size()); }
+            uint32_t levels() const { return uint32_t(levelBegin.size() - 1); }
+            uint32_t levelSize(int lod) const { return levelBegin[lod + 1] - levelBegin[lod]; }
+            uint32_t childCount(uint32_t node) const { return childBegin[node + 1] - childBegin[node]; }
+            uint32_t parentCount(uint32_t node) const { return parentBegin[node + 1] - parentBegin[node]; }
+            uint32_t meshLevelFirst(uint32_t mesh, int lod) const { return meshLevelBegin[size_t(lod) * meshCount + mesh]; }
+            uint32_t meshLevelEnd(uint32_t mesh, int lod) const { return meshLevelBegin[size_t(lod) * meshCount + mesh + 1]; }
+            uint32_t meshSize(uint32_t mesh) const
+            {
+                uint32_t nodes = 0;
+                for (int lod = 0; lod < int(levels()); lod++)
+                {
+                    nodes += meshLevelEnd(mesh, lod) - meshLevelFirst(mesh, lod);
+                }
+                return nodes;
+            }
+
+            // Fills meshCount, meshLevelBegin and meshNodes from meshIndices, throws when the nodes of a LoD are not sorted by mesh
+            void indexMeshes();
+            // Links every node to the nodes of the same mesh on the LoD below whose bounds overlap it, rebuilds childBegin
+            // and children. Candidates come from a uniform grid over the lower LoD of every mesh and the parents of a LoD
+            // are split over the threads, needs indexMeshes
+            void linkChildren(unsigned int numThreads);
+            // The all-pairs scan the grid has to agree with, kept for the benchmark
+            void linkChildrenAllPairs();
+            // Rebuilds parentBegin and parents from the child lists, both linkers call it
+            void linkParents();
+            // Replaces the errors with an upper bound of the one sided Hausdorff distance of every node to the surface of its
+            // children plus the error of those children, meshlets[n] is the meshlet of node n and needs its vertices and indices
+            void measureErrors(const std::vector<const Meshlet *> &meshlets, unsigned int numThreads);
+            // Makes the errors monotonic from the leaves up and fills errorSpheres, parentErrors and parentSpheres
+            void buildErrorBounds();
+
+            size_t memoryUsage() const
+            {
+                return (levelBegin.size() + meshLevelBegin.size() + meshNodes.size()) * sizeof(uint32_t) + bounds.size() * sizeof(BoundingBox) + centers.size() * sizeof(glm::vec3) +
+                       errors.size() * sizeof(float) + lods.size() * sizeof(uint8_t) + childBegin.size() * sizeof(uint32_t) +
+                       children.size() * sizeof(uint32_t) + parentBegin.size() * sizeof(uint32_t) + parents.size() * sizeof(uint32_t) +
+                       (errorSpheres.size() + parentSpheres.size() + cones.size()) * sizeof(glm::vec4) + parentErrors.size() * sizeof(float) + (meshIndices.size() + meshletIndices.size() + triangleCounts.size()) * sizeof(uint32_t);
+            }
+
+            void clear()
+            {
+                levelBegin = {0};
+                meshCount = 0;
+                meshLevelBegin = {0};
+                meshNodes.clear();
+                bounds.clear();
+                centers.clear();
+                errors.clear();
+                lods.clear();
+                cones.clear();
+                childBegin = {0};
+                children.clear();
+                parentBegin = {0};
+                parents.clear();
+                errorSpheres.clear();
+                parentErrors.clear();
+                parentSpheres.clear();
+                meshIndices.clear();
+                meshletIndices.clear();
+                triangleCounts.clear();
+            }
+        }; // struct DAG
 
     }; // class GraphBuilder
 
+    // A placement of one of the unique meshes in the scene, all instances of a mesh share its LoDs, meshlets, DAG nodes
+    // and uploaded geometry. The transforms are rigid so that distances and errors are the same in both spaces.
+    struct Instance
+    {
+        uint32_t mesh = 0;                     // The unique mesh, its LoDs are meshes[mesh * (MAX_LOD + 1) ...]
+        glm::mat4 transform = glm::mat4(1.0f); // Model space to world space
+        glm::mat4 inverse = glm::mat4(1.0f);   // World space to model space
+    }; // struct Instance
+
     struct World // can't call this scene because Jinsoku's update now has a scene
     {
         std::vector<float> simplification_errors; // The list of simplification errors for each of the LoDs in world space
-        std::vector<std::string> mesh_paths;      // The paths to the meshes in the scene
+        std::vector<std::string> mesh_paths;      // The paths to the meshes in the scene, one per instance
 
-        std::vector<Mesh> meshes; // The list of meshes in the scene
+        std::vector<Mesh> meshes; // The LoDs of every unique mesh in the scene, repeated paths are instances of the same mesh
+
+        std::vector<Instance> instances; // One per path, the game objects and object data are per instance
 
         lod::Model model; // This is for some reason needed in Jinsoku
 
@@ -237,7 +386,20 @@ namespace lod
 
         glm::vec3 center = glm::vec3(0.0f); // The center of the scene
 
-        std::vector<glm::vec3> mesh_centers{};
+        std::vector<glm::vec3> mesh_centers{}; // The world space center of every instance
+        lod::BoundsSoA mesh_bounds;           // The model space AABB of every unique mesh over all of its LoDs
+        lod::BoundsSoA instance_bounds;       // The world space AABB of every instance, used to cull whole instances
+        std::vector<uint32_t> movedInstances; // Instances moved since the last selection, it refits its instance BVH with them
+
+        // The moves of setObjectData, an instance and what its transform is multiplied with. They are applied once no
+        // selection runs, which moves the bounds of the instance and adds it to movedInstances
+        std::vector<std::pair<uint32_t, glm::mat4>> pendingMoves;
+
+        // The model space triangles of the coarsest LoD of every unique mesh for the occlusion culling, three positions per triangle
+        // The triangles of mesh m are [occluderBegin[m], occluderBegin[m + 1]) and each one has the error of its node
+        std::vector<glm::vec3> occluderPositions;
+        std::vector<float> occluderMargins;
+        std::vector<uint32_t> occluderBegin{0};
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,241 @@
+// internal includes
+#include "lodInstances.hpp"
+
+// std library includes
+#include <algorithm>
+#include <cfloat>
+#include <functional>
+#include <numeric>
+#include <thread>
+
+namespace lod
+{
+    uint32_t InstanceBVH::subtreeSize(uint32_t count)
+    {
+        if (count <= LEAF_SIZE)
+        {
+            return 1;
+        }
+
+        return 1 + subtreeSize(count / 2) + subtreeSize(count - count / 2);
+    }
+
+    void InstanceBVH::build(const BoundsSoA &instanceBounds, unsigned numThreads)
+    {
+        const uint32_t count = uint32_t(instanceBounds.size());
+
+        order.resize(count);
+        std::iota(order.begin(), order.end(), 0);
+        leafOf.assign(count, 0);
+
+        nodes.clear();
+        bounds.clear();
+
+        if (count == 0)
+        {
+            return;
+        }
+
+        // Every node is written by exactly one thread, nothing is allocated while building
+        const uint32_t nodeCount = subtreeSize(count);
+        nodes.resize(nodeCount);
+        for (auto *component : {&bounds.minX, &bounds.minY, &bounds.minZ, &bounds.maxX, &bounds.maxY, &bounds.maxZ})
+        {
+            component->resize(nodeCount);
+        }
+
+        buildRange(instanceBounds, 0, 0, 0, count, std::max(numThreads, 1u));
+    }
+
+    void InstanceBVH::buildRange(const BoundsSoA &instanceBounds, uint32_t node, uint32_t parent, uint32_t first, uint32_t count, unsigned threads)
+    {
+        nodes[node].first = first;
+        nodes[node].count = count;
+        nodes[node].right = 0;
+        nodes[node].parent = parent;
+
+        if (count <= LEAF_SIZE)
+        {
+            for (uint32_t i = first; i < first + count; i++)
+            {
+                leafOf[order[i]] = node;
+            }
+
+            fitNode(instanceBounds, node);
+            return;
+        }
+
+        // The longest axis of the box centers, the centers are kept doubled
+        glm::vec3 centerMin(FLT_MAX);
+        glm::vec3 centerMax(-FLT_MAX);
+        for (uint32_t i = first; i < first + count; i++)
+        {
+            BoundingBox bb = instanceBounds[order[i]];
+            centerMin = glm::min(centerMin, bb.minPoint + bb.maxPoint);
+            centerMax = glm::max(centerMax, bb.minPoint + bb.maxPoint);
+        }
+
+        glm::vec3 extent = centerMax - centerMin;
+        int axis = (extent.x >= extent.y) ? ((extent.x >= extent.z) ? 0 : 2) : ((extent.y >= extent.z) ? 1 : 2);
+
+        const std::vector<float> *minimum[3] = {&instanceBounds.minX, &instanceBounds.minY, &instanceBounds.minZ};
+        const std::vector<float> *maximum[3] = {&instanceBounds.maxX, &instanceBounds.maxY, &instanceBounds.maxZ};
+        const std::vector<float> &lower = *minimum[axis];
+        const std::vector<float> &upper = *maximum[axis];
+
+        const uint32_t half = count / 2;
+        std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count, [&](uint32_t a, uint32_t b)
+                         { return lower[a] + upper[a] < lower[b] + upper[b]; });
+
+        const uint32_t left = node + 1;
+        const uint32_t right = node + 1 + subtreeSize(half);
+        nodes[node].right = right;
+
+        if (threads > 1)
+        {
+            std::thread thread(&InstanceBVH::buildRange, this, std::cref(instanceBounds), left, node, first, half, threads / 2);
+            buildRange(instanceBounds, right, node, first + half, count - half, threads - threads / 2);
+            thread.join();
+        }
+        else
+        {
+            buildRange(instanceBounds, left, node, first, half, 1);
+            buildRange(instanceBounds, right, node, first + half, count - half, 1);
+        }
+
+        fitNode(instanceBounds, node);
+    }
+
+    // A leaf encloses its instances and an internal node its two children
+    void InstanceBVH::fitNode(const BoundsSoA &instanceBounds, uint32_t node)
+    {
+        BoundingBox fitted;
+
+        if (nodes[node].right == 0)
+        {
+            fitted = instanceBounds[order[nodes[node].first]];
+            for (uint32_t i = nodes[node].first + 1; i < nodes[node].first + nodes[node].count; i++)
+            {
+                BoundingBox bb = instanceBounds[order[i]];
+                fitted.minPoint = glm::min(fitted.minPoint, bb.minPoint);
+                fitted.maxPoint = glm::max(fitted.maxPoint, bb.maxPoint);
+            }
+        }
+        else
+        {
+            BoundingBox left = bounds[node + 1];
+            BoundingBox right = bounds[nodes[node].right];
+            fitted.minPoint = glm::min(left.minPoint, right.minPoint);
+            fitted.maxPoint = glm::max(left.maxPoint, right.maxPoint);
+        }
+
+        bounds.set(node, fitted);
+    }
+
+    void InstanceBVH::refit(const BoundsSoA &instanceBounds, const std::vector<uint32_t> &moved)
+    {
+        if (nodes.empty())
+        {
+            return;
+        }
+
+        // The moved leaves and everything above them, parents have lower ids so refitting from the highest id down
+        // refits every child before its parent
+        std::vector<uint32_t> dirty;
+        for (uint32_t instance : moved)
+        {
+            for (uint32_t node = leafOf[instance];; node = nodes[node].parent)
+            {
+                dirty.push_back(node);
+                if (node == 0)
+                {
+                    break;
+                }
+            }
+        }
+
+        std::sort(dirty.begin(), dirty.end(), std::greater<uint32_t>());
+        dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+
+        for (uint32_t node : dirty)
+        {
+            fitNode(instanceBounds, node);
+        }
+    }
+
+    void InstanceBVH::query(const BoundsSoA &instanceBounds, const FrustumPlanes &planes, const glm::vec3 &position, float maxDistance, std::vector<uint32_t> &visible) const
+    {
+        if (nodes.empty())
+        {
+            return;
+        }
+
+        // Nearest and furthest point of a box against the distance, one of -1 outside, 0 crossing, 1 inside
+        auto distanceTest = [&](const BoundingBox &bb)
+        {
+            glm::vec3 nearest = glm::clamp(position, bb.minPoint, bb.maxPoint);
+            if (glm::length(nearest - position) > maxDistance)
+            {
+                return -1;
+            }
+
+            glm::vec3 furthest = glm::max(glm::abs(position - bb.minPoint), glm::abs(position - bb.maxPoint));
+            return (glm::length(furthest) <= maxDistance) ? 1 : 0;
+        };
+
+        std::vector<std::pair<uint32_t, bool>> stack{{0, false}}; // The node and whether its parent was completely accepted by the frustum
+
+        while (!stack.empty())
+        {
+            auto [node, inside] = stack.back();
+            stack.pop_back();
+
+            if (!inside)
+            {
+                CullResult result;
+                cullBounds_scalar(planes, bounds, &node, 1, &result);
+                if (result == CULL_OUTSIDE)
+                {
+                    continue;
+                }
+                inside = result == CULL_INSIDE;
+            }
+
+            int distance = distanceTest(bounds[node]);
+            if (distance < 0)
+            {
+                continue;
+            }
+
+            const Node &current = nodes[node];
+
+            if (inside && (distance > 0))
+            {
+                visible.insert(visible.end(), order.begin() + current.first, order.begin() + current.first + current.count);
+            }
+            else if (current.right == 0)
+            {
+                // The leaf is crossing a plane or the distance, its few instances are tested on their own
+                for (uint32_t i = current.first; i < current.first + current.count; i++)
+                {
+                    CullResult result = CULL_INSIDE;
+                    if (!inside)
+                    {
+                        cullBounds_scalar(planes, instanceBounds, &order[i], 1, &result);
+                    }
+
+                    if ((result != CULL_OUTSIDE) && (distanceTest(instanceBounds[order[i]]) >= 0))
+                    {
+                        visible.push_back(order[i]);
+                    }
+                }
+            }
+            else
+            {
+                stack.push_back({current.right, inside});
+                stack.push_back({node + 1, inside});
+            }
+        }
+    }
+
+} // namespace lod
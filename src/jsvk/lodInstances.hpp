@@ -0,0 +1,58 @@
+#pragma once
+
+// Internal includes
+#include "lodCulling.hpp"
+#include "lodGeometry.hpp"
+
+// Std library includes
+#include <cstdint>
+#include <vector>
+
+// External includes
+#include <glm/glm.hpp>
+
+namespace lod
+{
+    // A binary BVH over the world space boxes of the instances, whole groups of instances are rejected before any of
+    // their DAG nodes are looked at. The nodes are stored depth first: the left child of an internal node is the next
+    // node and every parent comes before its children. Splits are at the median of the longest axis, which fixes the
+    // size of every subtree in advance so that the subtrees are built on different threads into their own part of the array.
+    class InstanceBVH
+    {
+    public:
+        static const uint32_t LEAF_SIZE = 4; // Instances per leaf at most
+
+        // Builds the tree over all boxes, the subtrees below the first levels are built on up to numThreads threads
+        void build(const BoundsSoA &instanceBounds, unsigned numThreads);
+
+        // Updates the boxes of the leaves holding the moved instances and of their ancestors, the tree keeps its shape
+        // so it gets looser the further the instances move away from where they were when it was built
+        void refit(const BoundsSoA &instanceBounds, const std::vector<uint32_t> &moved);
+
+        // Appends the instances whose box intersects the frustum and is nearer to position than maxDistance, subtrees
+        // completely inside both are accepted without looking at what is below them
+        void query(const BoundsSoA &instanceBounds, const FrustumPlanes &planes, const glm::vec3 &position, float maxDistance, std::vector<uint32_t> &visible) const;
+
+        uint32_t size() const { return uint32_t(nodes.size()); }
+        uint32_t instanceCount() const { return uint32_t(order.size()); }
+
+    private:
+        struct Node
+        {
+            uint32_t first = 0;  // The first instance of the subtree in order, a subtree is a contiguous range
+            uint32_t count = 0;  // Instances in the subtree
+            uint32_t right = 0;  // The right child, 0 for leaves since the root is nobody's child
+            uint32_t parent = 0; // The root is its own parent
+        };
+
+        std::vector<Node> nodes;
+        BoundsSoA bounds;             // The box of every node, laid out for cullBounds
+        std::vector<uint32_t> order;  // The instances sorted so that every subtree holds a contiguous range
+        std::vector<uint32_t> leafOf; // The leaf of every instance
+
+        static uint32_t subtreeSize(uint32_t count);
+        void buildRange(const BoundsSoA &instanceBounds, uint32_t node, uint32_t parent, uint32_t first, uint32_t count, unsigned threads);
+        void fitNode(const BoundsSoA &instanceBounds, uint32_t node);
+    }; // class InstanceBVH
+
+} // namespace lod
@@ -0,0 +1,304 @@
+// internal includes
+#include "lodOcclusion.hpp"
+
+// std library includes
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LOD_OCCLUSION_SSE 1
+#endif
+
+namespace lod
+{
+    void OcclusionBuffer::resize(uint32_t newWidth, float aspect)
+    {
+        width = std::max(TILE_SIZE, (newWidth + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE);
+
+        // Whole bands so every band covers whole tiles
+        height = uint32_t(std::lround(float(width) / std::max(aspect, 0.01f)));
+        height = std::max(BAND_HEIGHT, (height + BAND_HEIGHT - 1) / BAND_HEIGHT * BAND_HEIGHT);
+
+        tilesX = width / TILE_SIZE;
+
+        depth.assign(size_t(width) * height, FLT_MAX);
+        tileMax.assign(size_t(tilesX) * (height / TILE_SIZE), FLT_MAX);
+    }
+
+    void OcclusionBuffer::setup(const glm::mat4 &newViewProjection, float newNear, const std::vector<glm::vec3> &positions, const std::vector<float> &margins)
+    {
+        viewProjection = newViewProjection;
+        near = newNear;
+
+        triangles.clear();
+
+        for (size_t t = 0; 3 * t + 2 < positions.size(); t++)
+        {
+            ScreenTriangle triangle;
+            bool clipped = false;
+
+            for (int v = 0; v < 3; v++)
+            {
+                glm::vec4 clip = viewProjection * glm::vec4(positions[3 * t + v], 1.0f);
+
+                // Triangles crossing the near plane are left out, an occluder that is missing only makes the test more conservative
+                if (clip.w < near)
+                {
+                    clipped = true;
+                    break;
+                }
+
+                triangle.invW[v] = 1.0f / clip.w;
+                triangle.x[v] = (clip.x * triangle.invW[v] * 0.5f + 0.5f) * float(width);
+                triangle.y[v] = (clip.y * triangle.invW[v] * 0.5f + 0.5f) * float(height);
+            }
+
+            if (clipped)
+            {
+                continue;
+            }
+
+            // Both windings occlude, the area only decides the orientation of the edges
+            float area = (triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) - (triangle.x[2] - triangle.x[0]) * (triangle.y[1] - triangle.y[0]);
+            if (std::abs(area) < 1.0e-6f)
+            {
+                continue;
+            }
+            if (area < 0.0f)
+            {
+                std::swap(triangle.x[1], triangle.x[2]);
+                std::swap(triangle.y[1], triangle.y[2]);
+                std::swap(triangle.invW[1], triangle.invW[2]);
+            }
+
+            float minX = std::min({triangle.x[0], triangle.x[1], triangle.x[2]});
+            float maxX = std::max({triangle.x[0], triangle.x[1], triangle.x[2]});
+            float minY = std::min({triangle.y[0], triangle.y[1], triangle.y[2]});
+            float maxY = std::max({triangle.y[0], triangle.y[1], triangle.y[2]});
+
+            if ((maxX < 0.0f) || (minX >= float(width)) || (maxY < 0.0f) || (minY >= float(height)))
+            {
+                continue;
+            }
+
+            triangle.margin = (t < margins.size()) ? margins[t] : 0.0f;
+            triangle.minY = std::max(0, int(std::floor(minY)));
+            triangle.maxY = std::min(int(height) - 1, int(std::ceil(maxY)));
+
+            triangles.push_back(triangle);
+        }
+    }
+
+    void OcclusionBuffer::rasterizeBand(uint32_t band)
+    {
+        rasterize(band, false);
+    }
+
+    void OcclusionBuffer::rasterizeBand_scalar(uint32_t band)
+    {
+        rasterize(band, true);
+    }
+
+    void OcclusionBuffer::rasterize(uint32_t band, bool scalar)
+    {
+        const int bandMinY = int(band * BAND_HEIGHT);
+        const int bandMaxY = bandMinY + int(BAND_HEIGHT) - 1;
+
+        std::fill(depth.begin() + size_t(bandMinY) * width, depth.begin() + size_t(bandMaxY + 1) * width, FLT_MAX);
+
+        for (const ScreenTriangle &triangle : triangles)
+        {
+            if ((triangle.maxY >= bandMinY) && (triangle.minY <= bandMaxY))
+            {
+                rasterizeTriangle(triangle, bandMinY, bandMaxY, scalar);
+            }
+        }
+
+        // The furthest pixel of every tile in the band
+        for (uint32_t tileY = uint32_t(bandMinY) / TILE_SIZE; tileY <= uint32_t(bandMaxY) / TILE_SIZE; tileY++)
+        {
+            for (uint32_t tileX = 0; tileX < tilesX; tileX++)
+            {
+                float furthest = 0.0f;
+                for (uint32_t y = tileY * TILE_SIZE; y < (tileY + 1) * TILE_SIZE; y++)
+                {
+                    const float *row = &depth[size_t(y) * width + tileX * TILE_SIZE];
+                    for (uint32_t x = 0; x < TILE_SIZE; x++)
+                    {
+                        furthest = std::max(furthest, row[x]);
+                    }
+                }
+                tileMax[size_t(tileY) * tilesX + tileX] = furthest;
+            }
+        }
+    }
+
+    // Pixel centers inside all three edges are covered, 1 / w is affine in screen space and is interpolated with the
+    // same edge functions. Both kernels evaluate them in the same order so that they write the same depth
+    void OcclusionBuffer::rasterizeTriangle(const ScreenTriangle &triangle, int bandMinY, int bandMaxY, bool scalar)
+    {
+        const float *x = triangle.x;
+        const float *y = triangle.y;
+
+        int minX = std::max(0, int(std::floor(std::min({x[0], x[1], x[2]}))));
+        int maxX = std::min(int(width) - 1, int(std::ceil(std::max({x[0], x[1], x[2]}))));
+        int minY = std::max(bandMinY, triangle.minY);
+        int maxY = std::min(bandMaxY, triangle.maxY);
+
+        // Edge e is a * px + b * py + c, positive inside
+        float a[3], b[3], c[3];
+        for (int e = 0; e < 3; e++)
+        {
+            int v0 = (e + 1) % 3;
+            int v1 = (e + 2) % 3;
+            a[e] = y[v0] - y[v1];
+            b[e] = x[v1] - x[v0];
+            c[e] = x[v0] * y[v1] - x[v1] * y[v0];
+        }
+
+        const float invArea = 1.0f / (c[0] + c[1] + c[2]);
+
+        // 1 / w as a plane over the screen
+        const float wA = (a[0] * triangle.invW[0] + a[1] * triangle.invW[1] + a[2] * triangle.invW[2]) * invArea;
+        const float wB = (b[0] * triangle.invW[0] + b[1] * triangle.invW[1] + b[2] * triangle.invW[2]) * invArea;
+        const float wC = (c[0] * triangle.invW[0] + c[1] * triangle.invW[1] + c[2] * triangle.invW[2]) * invArea;
+
+        // Start on a multiple of four so the vector loop stays inside the row
+        minX &= ~3;
+
+        for (int py = minY; py <= maxY; py++)
+        {
+            const float cy = float(py) + 0.5f;
+            float *row = &depth[size_t(py) * width];
+
+#if LOD_OCCLUSION_SSE
+            if (!scalar)
+            {
+                const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+                const __m128 zero = _mm_setzero_ps();
+                const __m128 one = _mm_set1_ps(1.0f);
+                const __m128 margin = _mm_set1_ps(triangle.margin);
+
+                for (int px = minX; px <= maxX; px += 4)
+                {
+                    const __m128 cx = _mm_add_ps(_mm_set1_ps(float(px)), offsets);
+
+                    __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+                    for (int e = 0; e < 3; e++)
+                    {
+                        __m128 edge = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[e]), cx), _mm_set1_ps(b[e] * cy + c[e]));
+                        inside = _mm_and_ps(inside, _mm_cmpge_ps(edge, zero));
+                    }
+
+                    if (_mm_movemask_ps(inside) == 0)
+                    {
+                        continue;
+                    }
+
+                    __m128 invW = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(wA), cx), _mm_set1_ps(wB * cy + wC));
+                    __m128 pixelDepth = _mm_add_ps(_mm_div_ps(one, invW), margin);
+
+                    __m128 current = _mm_loadu_ps(row + px);
+                    __m128 nearest = _mm_min_ps(current, pixelDepth);
+                    _mm_storeu_ps(row + px, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+                }
+                continue;
+            }
+#endif
+            for (int px = minX; px <= maxX; px++)
+            {
+                const float cx = float(px) + 0.5f;
+
+                bool inside = true;
+                for (int e = 0; e < 3; e++)
+                {
+                    inside &= (a[e] * cx + (b[e] * cy + c[e])) >= 0.0f;
+                }
+
+                if (inside)
+                {
+                    float pixelDepth = 1.0f / (wA * cx + (wB * cy + wC)) + triangle.margin;
+                    row[px] = std::min(row[px], pixelDepth);
+                }
+            }
+        }
+    }
+
+    bool OcclusionBuffer::isVisible(const BoundingBox &bb) const
+    {
+        float minX = FLT_MAX, minY = FLT_MAX;
+        float maxX = -FLT_MAX, maxY = -FLT_MAX;
+        float nearest = FLT_MAX;
+
+        for (int n = 0; n < 8; n++)
+        {
+            glm::vec3 corner((n & 1) ? bb.maxPoint.x : bb.minPoint.x, (n & 2) ? bb.maxPoint.y : bb.minPoint.y, (n & 4) ? bb.maxPoint.z : bb.minPoint.z);
+            glm::vec4 clip = viewProjection * glm::vec4(corner, 1.0f);
+
+            // Boxes reaching the camera can not be occluded
+            if (clip.w < near)
+            {
+                return true;
+            }
+
+            float sx = (clip.x / clip.w * 0.5f + 0.5f) * float(width);
+            float sy = (clip.y / clip.w * 0.5f + 0.5f) * float(height);
+
+            minX = std::min(minX, sx);
+            maxX = std::max(maxX, sx);
+            minY = std::min(minY, sy);
+            maxY = std::max(maxY, sy);
+            nearest = std::min(nearest, clip.w);
+        }
+
+        int x0 = std::max(0, int(std::floor(minX)));
+        int x1 = std::min(int(width) - 1, int(std::floor(maxX)));
+        int y0 = std::max(0, int(std::floor(minY)));
+        int y1 = std::min(int(height) - 1, int(std::floor(maxY)));
+
+        // Off screen, the frustum test decides
+        if ((x0 > x1) || (y0 > y1))
+        {
+            return true;
+        }
+
+        for (int tileY = y0 / int(TILE_SIZE); tileY <= y1 / int(TILE_SIZE); tileY++)
+        {
+            for (int tileX = x0 / int(TILE_SIZE); tileX <= x1 / int(TILE_SIZE); tileX++)
+            {
+                // Every pixel of the tile is in front of the box
+                if (tileMax[size_t(tileY) * tilesX + tileX] < nearest)
+                {
+                    continue;
+                }
+
+                int px0 = std::max(x0, tileX * int(TILE_SIZE));
+                int px1 = std::min(x1, (tileX + 1) * int(TILE_SIZE) - 1);
+                int py0 = std::max(y0, tileY * int(TILE_SIZE));
+                int py1 = std::min(y1, (tileY + 1) * int(TILE_SIZE) - 1);
+
+                for (int py = py0; py <= py1; py++)
+                {
+                    for (int px = px0; px <= px1; px++)
+                    {
+                        if (depth[size_t(py) * width + px] >= nearest)
+                        {
+                            return true;
+                        }
+                    }
+                }
+            }
+        }
+
+        return false;
+    }
+
+#if LOD_OCCLUSION_SSE
+    const char *OcclusionBuffer::kernel() { return "SSE"; }
+#else
+    const char *OcclusionBuffer::kernel() { return "scalar"; }
+#endif
+
+} // namespace lod
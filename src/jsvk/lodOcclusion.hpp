@@ -0,0 +1,74 @@
+#pragma once
+
+// Internal includes
+#include "lodGeometry.hpp"
+
+// Std library includes
+#include <cstdint>
+#include <vector>
+
+// External includes
+#include <glm/glm.hpp>
+
+namespace lod
+{
+    // A small software depth buffer the coarsest LoD of the nearest meshes is rasterized into, the DAG nodes are then
+    // tested against it on the CPU. Depth is the linear view depth and the buffer keeps the nearest occluder per pixel,
+    // every 8x8 tile also keeps its furthest pixel so that most boxes are decided without looking at the pixels.
+    // The rows are split in bands of whole tiles which can be rasterized on different threads.
+    class OcclusionBuffer
+    {
+    public:
+        static const uint32_t TILE_SIZE = 8;
+        static const uint32_t BAND_HEIGHT = 2 * TILE_SIZE;
+
+        // Sizes the buffer, the width is rounded up to whole tiles and the height follows the aspect ratio
+        void resize(uint32_t width, float aspect);
+
+        // Transforms the occluders for this frame, positions holds three vertices per triangle and margins one
+        // value per triangle that is added to its depth (the distance the triangle may be in front of the surface)
+        void setup(const glm::mat4 &viewProjection, float near, const std::vector<glm::vec3> &positions, const std::vector<float> &margins);
+
+        uint32_t bandCount() const { return height / BAND_HEIGHT; }
+        // Clears and rasterizes the rows of one band then updates the tiles of the band, bands are independent
+        void rasterizeBand(uint32_t band);
+        // One pixel at a time, the reference the SSE rasterizer has to agree with
+        void rasterizeBand_scalar(uint32_t band);
+
+        glm::uvec2 resolution() const { return glm::uvec2(width, height); }
+        float depthAt(uint32_t x, uint32_t y) const { return depth[size_t(y) * width + x]; }
+
+        // False when the box is completely behind the occluders
+        bool isVisible(const BoundingBox &bb) const;
+
+        uint32_t triangleCount() const { return uint32_t(triangles.size()); }
+
+        static const char *kernel();
+
+    private:
+        struct ScreenTriangle
+        {
+            float x[3];
+            float y[3];
+            float invW[3];
+            float margin;
+            int minY;
+            int maxY;
+        };
+
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t tilesX = 0;
+
+        glm::mat4 viewProjection = glm::mat4(1.0f);
+        float near = 0.01f;
+
+        std::vector<ScreenTriangle> triangles;
+        std::vector<float> depth;    // Nearest occluder per pixel, FLT_MAX where there is none
+        std::vector<float> tileMax;  // Furthest pixel of every tile
+
+        void rasterize(uint32_t band, bool scalar);
+        void rasterizeTriangle(const ScreenTriangle &triangle, int bandMinY, int bandMaxY, bool scalar);
+    }; // class OcclusionBuffer
+
+} // namespace lod
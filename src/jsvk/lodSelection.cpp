@@ -0,0 +1,200 @@
+// internal includes
+#include "lodSelection.hpp"
+#include "lodThreadStealers.hpp"
+
+// std library includes
+#include <queue>
+#include <utility>
+
+namespace lod
+{
+    uint64_t selectBudgetCut(const Graph::DAG &dag, const std::vector<uint32_t> &visibleInstances, const std::vector<InstanceView> &views, uint64_t budget,
+                             float near, std::vector<uint8_t> &state, std::vector<uint64_t> &cut)
+    {
+        // Where the states of the nodes of every visible instance start
+        std::vector<size_t> stateBegin(views.size(), 0);
+        size_t stateSize = 0;
+        for (uint32_t instance : visibleInstances)
+        {
+            stateBegin[instance] = stateSize;
+            stateSize += dag.meshSize(views[instance].mesh);
+        }
+        state.assign(stateSize, BUDGET_UNSEEN);
+
+        if (dag.levels() == 0)
+        {
+            return 0;
+        }
+
+        std::priority_queue<std::pair<float, uint64_t>> refinable; // Projected error and instance and node
+        uint64_t triangles = 0;
+
+        auto nodeState = [&](uint32_t instance, uint32_t node) -> uint8_t &
+        {
+            return state[stateBegin[instance] + dag.meshNodes[node]];
+        };
+
+        auto select = [&](uint32_t instance, uint32_t node)
+        {
+            nodeState(instance, node) = BUDGET_IN_CUT;
+
+            // Nodes outside the frustum are neither drawn nor refined and cost nothing
+            CullResult visibility;
+            cullBounds_scalar(views[instance].planes, dag.bounds, &node, 1, &visibility);
+            if (visibility == CULL_OUTSIDE)
+            {
+                return;
+            }
+
+            triangles += dag.triangleCounts[node];
+
+            if (dag.childCount(node) > 0)
+            {
+                refinable.push({projectedError(dag.errors[node], dag.errorSpheres[node], views[instance].position, near), drawnKey(instance, node)});
+            }
+            else
+            {
+                cut.push_back(drawnKey(instance, node));
+            }
+        };
+
+        const uint32_t roots = dag.levels() - 1;
+        for (uint32_t instance : visibleInstances)
+        {
+            const uint32_t mesh = views[instance].mesh;
+            for (uint32_t root = dag.meshLevelFirst(mesh, roots); root < dag.meshLevelEnd(mesh, roots); root++)
+            {
+                select(instance, root);
+            }
+        }
+
+        while (!refinable.empty())
+        {
+            uint32_t instance = drawnInstance(refinable.top().second);
+            uint32_t node = drawnNode(refinable.top().second);
+
+            // Children already in the cut or refined through another parent are not selected again, the others are
+            // counted even if they turn out to be outside the frustum
+            uint64_t refined = triangles - dag.triangleCounts[node];
+            for (uint32_t c = dag.childBegin[node]; c < dag.childBegin[node + 1]; c++)
+            {
+                refined += (nodeState(instance, dag.children[c]) == BUDGET_UNSEEN) ? dag.triangleCounts[dag.children[c]] : 0;
+            }
+
+            if (refined > budget)
+            {
+                break;
+            }
+
+            refinable.pop();
+            nodeState(instance, node) = BUDGET_REFINED;
+            triangles -= dag.triangleCounts[node];
+
+            for (uint32_t c = dag.childBegin[node]; c < dag.childBegin[node + 1]; c++)
+            {
+                if (nodeState(instance, dag.children[c]) == BUDGET_UNSEEN)
+                {
+                    select(instance, dag.children[c]);
+                }
+            }
+        }
+
+        // What is left in the heap was not refined and is part of the cut as it is
+        while (!refinable.empty())
+        {
+            cut.push_back(refinable.top().second);
+            refinable.pop();
+        }
+
+        return triangles;
+    }
+
+    void sortRanges(std::vector<uint64_t> &keys, std::vector<uint32_t> &nodes, RangeSortScratch &scratch, ThreadPool &pool)
+    {
+        const size_t count = keys.size();
+        if (count <= 1)
+        {
+            return;
+        }
+
+        scratch.keys.resize(count);
+        scratch.nodes.resize(count);
+
+        const size_t blocks = std::clamp(count / RADIX_BLOCK, size_t(1), pool.size() + 1);
+        const size_t blockSize = (count + blocks - 1) / blocks;
+        scratch.counts.resize(blocks);
+
+        uint64_t varying = 0;
+        for (uint64_t key : keys)
+        {
+            varying |= key ^ keys.front();
+        }
+
+        // Runs the tasks on the pool, or on the calling thread when there is only one
+        auto forEachBlock = [&](auto &&task)
+        {
+            if (blocks == 1)
+            {
+                task(0);
+                return;
+            }
+
+            for (size_t block = 0; block < blocks; block++)
+            {
+                pool.enqueue([&task, block]()
+                             { task(block); });
+            }
+            pool.wait();
+        };
+
+        for (uint32_t shift = 0; shift < 64; shift += RADIX_BITS)
+        {
+            if (((varying >> shift) & (RADIX_BUCKETS - 1)) == 0)
+            {
+                continue;
+            }
+
+            auto countBlock = [&, shift](size_t block)
+            {
+                std::array<uint32_t, RADIX_BUCKETS> &counts = scratch.counts[block];
+                counts.fill(0);
+
+                for (size_t i = block * blockSize; i < std::min(count, (block + 1) * blockSize); i++)
+                {
+                    counts[(keys[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+                }
+            };
+
+            auto scatterBlock = [&, shift](size_t block)
+            {
+                std::array<uint32_t, RADIX_BUCKETS> &offsets = scratch.counts[block];
+
+                for (size_t i = block * blockSize; i < std::min(count, (block + 1) * blockSize); i++)
+                {
+                    uint32_t target = offsets[(keys[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+                    scratch.keys[target] = keys[i];
+                    scratch.nodes[target] = nodes[i];
+                }
+            };
+
+            forEachBlock(countBlock);
+
+            uint32_t offset = 0;
+            for (uint32_t digit = 0; digit < RADIX_BUCKETS; digit++)
+            {
+                for (size_t block = 0; block < blocks; block++)
+                {
+                    uint32_t digitCount = scratch.counts[block][digit];
+                    scratch.counts[block][digit] = offset;
+                    offset += digitCount;
+                }
+            }
+
+            forEachBlock(scatterBlock);
+
+            keys.swap(scratch.keys);
+            nodes.swap(scratch.nodes);
+        }
+    }
+
+} // namespace lod
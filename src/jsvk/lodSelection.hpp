@@ -0,0 +1,85 @@
+#pragma once
+
+// Internal includes
+#include "lodCulling.hpp"
+#include "lodGeometry.hpp"
+
+// Std library includes
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// External includes
+#include <glm/glm.hpp>
+
+namespace lod
+{
+    class ThreadPool;
+
+    // A selected cluster is its instance in the high and its DAG node in the low 32 bits, sorting the keys groups the
+    // clusters of an instance together in node order
+    inline uint64_t drawnKey(uint32_t instance, uint32_t node) { return (uint64_t(instance) << 32) | node; }
+    inline uint32_t drawnInstance(uint64_t key) { return uint32_t(key >> 32); }
+    inline uint32_t drawnNode(uint64_t key) { return uint32_t(key); }
+
+    // The DAG of a mesh is shared by all of its instances and is selected in the model space of every instance, the
+    // camera position and the frustum are moved there once per frame
+    struct InstanceView
+    {
+        glm::vec3 position;   // The camera in model space
+        FrustumPlanes planes; // The frustum in model space
+        uint32_t mesh = 0;    // The mesh of the instance, only its nodes of the DAG are selected
+    };
+
+    // World space error over the distance to the nearest point of the sphere, the camera inside the sphere always refines
+    inline float projectedError(float error, const glm::vec4 &sphere, const glm::vec3 &position, float near)
+    {
+        float d = std::max(glm::length(position - glm::vec3(sphere)) - sphere.w, near);
+        return error / d;
+    }
+
+    // Where a node of an instance is while the budgeted cut is built
+    enum BudgetState : uint8_t
+    {
+        BUDGET_UNSEEN = 0,  // Not reached from any parent yet
+        BUDGET_IN_CUT = 1,  // Part of the cut, drawn unless it is refined later
+        BUDGET_REFINED = 2, // Replaced by its children, another parent reaching it does not select it again
+    };
+
+    // Budgeted LoD selection
+    // Starts from the roots of the mesh of every instance, the coarsest LoD, and keeps replacing the node with the largest projected error by its
+    // children until that would go over the triangle budget, so the cost of a frame stays the same wherever the camera
+    // is. The budget is shared by all visible instances, the nearer instances get more of it. Appends the nodes of the
+    // cut that are inside the frustum of their instance to cut, every node at most once, and returns their triangles.
+    // state holds a BudgetState per node of the mesh of every visible instance, one visible instance after the other
+    uint64_t selectBudgetCut(const Graph::DAG &dag, const std::vector<uint32_t> &visibleInstances, const std::vector<InstanceView> &views, uint64_t budget,
+                             float near, std::vector<uint8_t> &state, std::vector<uint64_t> &cut);
+
+    // Draw ranges
+    // A selected cluster is packed again as its instance in the top 24, its LoD in the next 8 and its meshlet index in
+    // the low 32 bits. Sorted, the meshlets of every instance and LoD are one run of increasing indices, so a range of
+    // sequential meshlets is always one draw whichever order the workers selected them in
+    inline uint64_t rangeKey(uint32_t instance, uint32_t lod, uint32_t meshletIndex) { return (uint64_t(instance) << 40) | (uint64_t(lod & 0xFF) << 32) | meshletIndex; }
+    inline uint32_t rangeInstance(uint64_t key) { return uint32_t(key >> 40); }
+    inline uint32_t rangeLOD(uint64_t key) { return uint32_t(key >> 32) & 0xFF; }
+    inline uint32_t rangeMeshlet(uint64_t key) { return uint32_t(key); }
+
+    const uint32_t RADIX_BITS = 8;
+    const uint32_t RADIX_BUCKETS = 1 << RADIX_BITS;
+    const size_t RADIX_BLOCK = 16384; // Keys per task at least, smaller selections are sorted on the calling thread
+
+    // The buffers of sortRanges, kept between frames so that sorting does not allocate
+    struct RangeSortScratch
+    {
+        std::vector<uint64_t> keys;
+        std::vector<uint32_t> nodes;
+        std::vector<std::array<uint32_t, RADIX_BUCKETS>> counts; // The digit histogram and then the scatter offsets of every block
+    };
+
+    // LSD radix sort of the range keys together with their nodes. Every block of keys is counted and scattered by its
+    // own task on the pool, the offsets are digit major and block minor so that every pass is stable. Digits that are
+    // the same in every key are skipped, which leaves the meshlet index and usually one or two bytes of the instance
+    void sortRanges(std::vector<uint64_t> &keys, std::vector<uint32_t> &nodes, RangeSortScratch &scratch, ThreadPool &pool);
+
+} // namespace lod
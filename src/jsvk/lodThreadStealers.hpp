@@ -0,0 +1,221 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <queue>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+
+namespace lod
+{
+    // A simple task queue for each thread
+    class TaskQueue
+    {
+    private:
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+        std::condition_variable cv;
+
+    public:
+        void push_back(std::function<void()> task)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(task));
+            cv.notify_one();
+        }
+
+        void push_front(std::function<void()> task)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_front(std::move(task));
+            cv.notify_one();
+        }
+
+        std::function<void()> pop_front()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (tasks.empty())
+                return {};
+            auto task = std::move(tasks.front());
+            tasks.pop_front();
+            return task;
+        }
+
+        std::function<void()> steal()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (tasks.empty())
+                return {};
+            auto task = std::move(tasks.back());
+            tasks.pop_back();
+            return task;
+        }
+    };
+
+    // One flag per DAG node that any thread can claim without a lock
+    class AtomicBitset
+    {
+    private:
+        std::vector<std::atomic<uint64_t>> words;
+
+    public:
+        // Clears the first bits flags, the words are only reallocated to grow since the number of flags follows the
+        // visible instances every frame. Only call while no thread is using the set
+        void reset(size_t bits)
+        {
+            const size_t count = (bits + 63) / 64;
+            if (words.size() < count)
+            {
+                words = std::vector<std::atomic<uint64_t>>(count);
+            }
+
+            for (size_t word = 0; word < count; word++)
+            {
+                words[word].store(0, std::memory_order_relaxed);
+            }
+        }
+
+        // Returns true for the one caller that set the flag
+        bool set(size_t bit)
+        {
+            uint64_t mask = uint64_t(1) << (bit % 64);
+            return (words[bit / 64].fetch_or(mask, std::memory_order_relaxed) & mask) == 0;
+        }
+    };
+
+    // A persistent thread pool with work stealing
+    // Every worker owns a TaskQueue, tasks enqueued by a worker go to the front of its own queue and idle workers steal
+    // from the back of the others. wait() is the latch for a whole traversal, it returns once every task and every task
+    // spawned by them has finished. The workers stay alive between traversals and sleep while there is no work.
+    class ThreadPool
+    {
+    private:
+        std::vector<std::thread> workers;
+        std::vector<std::unique_ptr<TaskQueue>> queues;
+
+        std::atomic<int64_t> pending{0}; // Enqueued tasks that have not finished yet
+        std::atomic<size_t> next{0};     // Spreads tasks enqueued from outside the pool over the queues
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        bool stop = false;
+
+        static inline thread_local size_t workerIndex = SIZE_MAX;
+
+        bool runTask(size_t index)
+        {
+            std::function<void()> task = queues[index]->pop_front();
+            for (size_t i = 1; !task && i < queues.size(); ++i)
+            {
+                task = queues[(index + i) % queues.size()]->steal();
+            }
+
+            if (!task)
+            {
+                return false;
+            }
+
+            task();
+
+            if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                done.notify_all();
+            }
+
+            return true;
+        }
+
+        void workerLoop(size_t index)
+        {
+            workerIndex = index;
+
+            while (true)
+            {
+                if (runTask(index))
+                {
+                    continue;
+                }
+
+                // Other workers are still running tasks that may spawn more
+                if (pending.load(std::memory_order_acquire) > 0)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this]
+                          { return stop || pending.load(std::memory_order_acquire) > 0; });
+                if (stop)
+                {
+                    return;
+                }
+            }
+        }
+
+    public:
+        ThreadPool(size_t threads)
+        {
+            threads = std::max<size_t>(threads, 1);
+
+            for (size_t i = 0; i < threads; ++i)
+            {
+                queues.push_back(std::make_unique<TaskQueue>());
+            }
+            for (size_t i = 0; i < threads; ++i)
+            {
+                workers.emplace_back(&ThreadPool::workerLoop, this, i);
+            }
+        }
+
+        ~ThreadPool()
+        {
+            wait();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stop = true;
+            }
+            wake.notify_all();
+            for (std::thread &worker : workers)
+            {
+                worker.join();
+            }
+        }
+
+        size_t size() const { return workers.size(); }
+
+        // The worker running the calling thread, size() for threads outside the pool
+        size_t currentWorker() const { return (workerIndex < workers.size()) ? workerIndex : workers.size(); }
+
+        template <class F>
+        void enqueue(F &&f)
+        {
+            size_t index = (workerIndex < queues.size()) ? workerIndex : (next.fetch_add(1, std::memory_order_relaxed) % queues.size());
+
+            bool wasIdle = pending.fetch_add(1, std::memory_order_acq_rel) == 0;
+            queues[index]->push_front(std::forward<F>(f));
+
+            if (wasIdle)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                wake.notify_all();
+            }
+        }
+
+        // Blocks until all enqueued work is done
+        void wait()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this]
+                      { return pending.load(std::memory_order_acquire) == 0; });
+        }
+    };
+}
@@ -99,6 +99,98 @@ namespace NVMeshlet
     static const uint32_t PRIMITIVE_PACKING_ALIGNMENT = 32; // must be multiple of PRIMITIVE_BITS_PER_FETCH
     static const uint32_t VERTEX_PACKING_ALIGNMENT = 16;
 
+    // Optional meshlet-relative packing of the vertex indices (NVMESHLET_VERTEX_DELTA).
+    // Every meshlet starts with one 32-bit header word that holds the smallest vertex
+    // index it references (lower 30 bits) and the width of the deltas (upper 2 bits).
+    // The deltas follow packed as 4x uint8 or 2x uint16 per word. Because the runs are
+    // much shorter than the plain uint32 ones, we use a smaller alignment for them.
+    // Keep in sync with shader configuration!
+    enum VertexIndexDeltaWidth
+    {
+        VERTEX_DELTA_UINT8 = 0,
+        VERTEX_DELTA_UINT16 = 1,
+        VERTEX_DELTA_UINT32 = 2,
+    };
+
+    static const uint32_t VERTEX_DELTA_PACKING_ALIGNMENT = 4;
+    static const uint32_t VERTEX_DELTA_BASE_BITS = 30;
+
+    inline uint32_t computeVertexDeltaWords(uint32_t numVertices, VertexIndexDeltaWidth width)
+    {
+        // header word + packed deltas
+        switch (width)
+        {
+        case VERTEX_DELTA_UINT8:
+            return 1 + (numVertices + 3) / 4;
+        case VERTEX_DELTA_UINT16:
+            return 1 + (numVertices + 1) / 2;
+        default:
+            return 1 + numVertices;
+        }
+    }
+
+    // mirrors the decode in meshlet.mesh
+    inline uint32_t unpackVertexIndexDelta(const uint32_t *packed, uint32_t vertexBegin, uint32_t v)
+    {
+        uint32_t header = packed[vertexBegin];
+        uint32_t base = header & ((1u << VERTEX_DELTA_BASE_BITS) - 1);
+        uint32_t width = header >> VERTEX_DELTA_BASE_BITS;
+        const uint32_t *deltas = packed + vertexBegin + 1;
+
+        if (width == VERTEX_DELTA_UINT8)
+            return base + ((deltas[v / 4] >> ((v % 4) * 8)) & 0xFF);
+        if (width == VERTEX_DELTA_UINT16)
+            return base + ((deltas[v / 2] >> ((v % 2) * 16)) & 0xFFFF);
+        return base + deltas[v];
+    }
+
+    // Optional generalized triangle strip packing of the primitive indices (NVMESHLET_PRIMITIVE_STRIPS).
+    // Every meshlet starts with three bit masks of one bit per triangle: restart, fan and flip.
+    // The uint8 strip entries follow. A restart triangle adds three entries, every other triangle
+    // adds one and reuses the edge of its predecessor. Triangle t is (other, last - 1, last), where
+    // last is its newest entry and other is last - 2 unless t is a fan step, which keeps the other
+    // of its predecessor. Flip swaps the first two indices to restore the winding.
+    // Keep in sync with shader configuration!
+    inline uint32_t computeStripMaskWords(uint32_t numPrims)
+    {
+        return (numPrims + 31) / 32;
+    }
+
+    inline uint32_t computeStripSize(uint32_t numPrims, uint32_t numEntries)
+    {
+        return computeStripMaskWords(numPrims) * 3 * sizeof(uint32_t) + numEntries;
+    }
+
+    // mirrors the decode in meshlet.mesh
+    inline void unpackPrimitiveStrip(const uint8_t *strip, uint32_t numPrims, uint8_t (*triangles)[3])
+    {
+        const uint32_t maskWords = computeStripMaskWords(numPrims);
+        const uint8_t *entries = strip + maskWords * 3 * sizeof(uint32_t);
+
+        uint32_t next = 0;
+        uint32_t other = 0;
+        for (uint32_t t = 0; t < numPrims; t++)
+        {
+            uint32_t masks[3];
+            for (uint32_t m = 0; m < 3; m++)
+            {
+                memcpy(&masks[m], strip + ((m * maskWords) + (t / 32)) * sizeof(uint32_t), sizeof(uint32_t));
+                masks[m] = (masks[m] >> (t % 32)) & 1;
+            }
+
+            uint32_t last = next + (masks[0] ? 3 : 1) - 1;
+            if (!masks[1])
+            {
+                other = last - 2;
+            }
+            next = last + 1;
+
+            triangles[t][0] = entries[masks[2] ? last - 1 : other];
+            triangles[t][1] = entries[masks[2] ? other : last - 1];
+            triangles[t][2] = entries[last];
+        }
+    }
+
     inline uint32_t computeTasksCount(uint32_t numMeshlets)
     {
         return (numMeshlets + MESHLETS_PER_TASK - 1) / MESHLETS_PER_TASK;
@@ -226,7 +318,17 @@ namespace NVMeshlet
             fieldZ |= pack(begin / VERTEX_PACKING_ALIGNMENT, 20, 0);
         }
 
+        // same field, but addressing the delta packed vertex indices
+        uint32_t getVertexBeginDelta() const { return unpack(fieldZ, 20, 0) * VERTEX_DELTA_PACKING_ALIGNMENT; }
+        void setVertexBeginDelta(uint32_t begin)
+        {
+            assert(begin % VERTEX_DELTA_PACKING_ALIGNMENT == 0);
+            assert(begin / VERTEX_DELTA_PACKING_ALIGNMENT < ((1 << 20) - 1));
+            fieldZ = (fieldZ & ~pack(0xFFFFF, 20, 0)) | pack(begin / VERTEX_DELTA_PACKING_ALIGNMENT, 20, 0);
+        }
+
         uint32_t getPrimBegin() const { return unpack(fieldW, 20, 0) * PRIMITIVE_PACKING_ALIGNMENT; }
+        void resetPrimBegin() { fieldW &= ~pack(0xFFFFF, 20, 0); }
         void setPrimBegin(uint32_t begin)
         {
             assert(begin % PRIMITIVE_PACKING_ALIGNMENT == 0);
@@ -284,6 +386,8 @@ namespace NVMeshlet
         static bool isPrimBeginLegal(uint32_t begin) { return begin / PRIMITIVE_PACKING_ALIGNMENT < ((1 << 20) - 1); }
 
         static bool isVertexBeginLegal(uint32_t begin) { return begin / VERTEX_PACKING_ALIGNMENT < ((1 << 20) - 1); }
+
+        static bool isVertexBeginDeltaLegal(uint32_t begin) { return begin / VERTEX_DELTA_PACKING_ALIGNMENT < ((1 << 20) - 1); }
     };
 
     inline uint64_t computeCommonAlignedSize(uint64_t size)
@@ -10,4 +10,10 @@
 %VK_SDK_PATH%/Bin/glslc.exe --target-env=vulkan1.3 --target-spv=spv1.3 meshlet.mesh -o meshletMesh.spv
 
 %VK_SDK_PATH%/Bin/glslc.exe --target-env=vulkan1.3 --target-spv=spv1.3 meshletTexture.mesh -o meshletTextureMesh.spv
-%VK_SDK_PATH%/Bin/glslc.exe meshletTexture.frag -o meshletTextureFrag.spv
\ No newline at end of file
+%VK_SDK_PATH%/Bin/glslc.exe meshletTexture.frag -o meshletTextureFrag.spv
+
+rem The delta packed vertex indices are off in config.h, the variant is only built so its decode keeps compiling
+%VK_SDK_PATH%/Bin/glslc.exe --target-env=vulkan1.3 --target-spv=spv1.3 -DNVMESHLET_VERTEX_DELTA=1 meshlet.mesh -o %TEMP%/meshletMeshDelta.spv
+
+rem The primitive strips are off in config.h as well, their decode is built the same way
+%VK_SDK_PATH%/Bin/glslc.exe --target-env=vulkan1.3 --target-spv=spv1.3 -DNVMESHLET_PRIMITIVE_STRIPS=1 meshlet.mesh -o %TEMP%/meshletMeshStrips.spv
\ No newline at end of file
@@ -333,6 +333,13 @@ struct ObjectData
 	glm::vec4 color;
 };
 
+// The push constants of one draw of a range of the LoD cut, taken on the render thread and recorded on any
+struct DrawRange
+{
+	glm::uvec4 geometryOffsets; // Meshlet, primitive, vertex index and vertex offsets like the push constants of drawDynamic
+	glm::uvec4 assigns;			// The object, the last meshlet of the range, the LoD and the first meshlet
+};
+
 #define NUM_CLIPPING_PLANES 3
 
 struct SceneData
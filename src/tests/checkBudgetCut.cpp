@@ -0,0 +1,208 @@
+#include "checks.h"
+
+#include "jsvk/lodSelection.hpp"
+
+#include <random>
+#include <set>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Planes that keep everything, the selection is then only decided by the errors and the budget
+static lod::FrustumPlanes allInside()
+{
+	lod::FrustumPlanes planes;
+	for (int p = 0; p < 6; p++)
+	{
+		planes.nx[p] = (p == 0) ? 1.0f : 0.0f;
+		planes.ny[p] = 0.0f;
+		planes.nz[p] = 0.0f;
+		planes.d[p] = 1e9f;
+	}
+	return planes;
+}
+
+// The DAG from the child lists of every node, levels[l] is the number of nodes of LoD l. All nodes are of mesh 0
+// unless meshes has the mesh of every node
+static lod::Graph::DAG makeDAG(const std::vector<uint32_t> &levels, const std::vector<std::vector<uint32_t>> &children, const std::vector<float> &errors,
+							   const std::vector<uint32_t> &triangles, const std::vector<uint32_t> &meshes = {})
+{
+	lod::Graph::DAG dag;
+
+	for (uint32_t lod = 0; lod < levels.size(); lod++)
+	{
+		dag.levelBegin.push_back(dag.levelBegin.back() + levels[lod]);
+		for (uint32_t n = 0; n < levels[lod]; n++)
+		{
+			dag.lods.push_back(uint8_t(lod));
+		}
+	}
+
+	for (uint32_t node = 0; node < children.size(); node++)
+	{
+		lod::BoundingBox bb;
+		bb.minPoint = glm::vec3(-1.0f);
+		bb.maxPoint = glm::vec3(1.0f);
+		dag.bounds.push_back(bb);
+
+		dag.children.insert(dag.children.end(), children[node].begin(), children[node].end());
+		dag.childBegin.push_back(uint32_t(dag.children.size()));
+		dag.errorSpheres.push_back(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+	}
+
+	dag.errors = errors;
+	dag.triangleCounts = triangles;
+	dag.meshIndices = meshes.empty() ? std::vector<uint32_t>(children.size(), 0) : meshes;
+	dag.indexMeshes();
+	return dag;
+}
+
+static uint64_t cutTriangles(const lod::Graph::DAG &dag, const std::vector<uint64_t> &cut)
+{
+	uint64_t triangles = 0;
+	for (uint64_t key : cut)
+	{
+		triangles += dag.triangleCounts[lod::drawnNode(key)];
+	}
+	return triangles;
+}
+
+// A node refined through one parent and reached again through another one stays refined
+static void checkSharedChild()
+{
+	// Leaves 0 .. 4, then A = 5, B = 6, D = 7 and the roots R1 = 8, R2 = 9. A is a child of both roots
+	std::vector<std::vector<uint32_t>> children = {{}, {}, {}, {}, {}, {0, 1}, {4}, {2, 3}, {5, 6}, {5, 7}};
+	std::vector<float> errors = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 8.0f, 1.0f, 9.0f, 10.0f, 5.0f};
+	std::vector<uint32_t> triangles = {10, 10, 1000, 1000, 10, 10, 10, 10, 10, 10};
+	lod::Graph::DAG dag = makeDAG({5, 3, 2}, children, errors, triangles);
+
+	std::vector<lod::InstanceView> views = {{glm::vec3(0.0f, 0.0f, 10.0f), allInside()}};
+	std::vector<uint8_t> state;
+	std::vector<uint64_t> cut;
+
+	// R1 and A are refined, R2 reaches A again and D does not fit
+	uint64_t selected = lod::selectBudgetCut(dag, {0}, views, 100, 0.01f, state, cut);
+
+	std::set<uint32_t> nodes;
+	for (uint64_t key : cut)
+	{
+		nodes.insert(lod::drawnNode(key));
+	}
+	assert(nodes.size() == cut.size());
+	assert((nodes == std::set<uint32_t>{0, 1, 6, 7}));
+	assert(state[5] == lod::BUDGET_REFINED);
+	assert(selected == cutTriangles(dag, cut));
+	assert(selected <= 100);
+}
+
+// Every instance only selects the nodes of its own mesh
+static void checkMeshes()
+{
+	// Leaves 0 and 1 of mesh 0 and 2 and 3 of mesh 1, the roots are 4 of mesh 0 and 5 of mesh 1
+	std::vector<std::vector<uint32_t>> children = {{}, {}, {}, {}, {0, 1}, {2, 3}};
+	std::vector<float> errors = {0.0f, 0.0f, 0.0f, 0.0f, 10.0f, 10.0f};
+	std::vector<uint32_t> triangles = {10, 10, 10, 10, 10, 10};
+	lod::Graph::DAG dag = makeDAG({4, 2}, children, errors, triangles, {0, 0, 1, 1, 0, 1});
+	assert(dag.meshCount == 2);
+
+	// Instance 1 is culled, instance 2 is another instance of mesh 0
+	std::vector<lod::InstanceView> views = {{glm::vec3(0.0f, 0.0f, 10.0f), allInside(), 1}, {glm::vec3(0.0f), allInside(), 1}, {glm::vec3(0.0f, 0.0f, 10.0f), allInside(), 0}};
+
+	for (uint64_t budget : {uint64_t(20), UINT64_MAX})
+	{
+		std::vector<uint8_t> state;
+		std::vector<uint64_t> cut;
+		lod::selectBudgetCut(dag, {0, 2}, views, budget, 0.01f, state, cut);
+
+		// The state covers the three nodes of mesh 1 and then the three of mesh 0
+		assert(state.size() == 6);
+
+		std::set<uint64_t> nodes(cut.begin(), cut.end());
+		if (budget == UINT64_MAX)
+		{
+			assert((nodes == std::set<uint64_t>{lod::drawnKey(0, 2), lod::drawnKey(0, 3), lod::drawnKey(2, 0), lod::drawnKey(2, 1)}));
+		}
+		else
+		{
+			assert((nodes == std::set<uint64_t>{lod::drawnKey(0, 5), lod::drawnKey(2, 4)}));
+		}
+	}
+}
+
+// Random DAGs with shared children: every node at most once, never one that was refined and within the budget
+static void checkRandomDAGs()
+{
+	std::mt19937 rng(7);
+
+	for (int round = 0; round < 200; round++)
+	{
+		std::vector<uint32_t> levels = {64, 24, 8, 2};
+		std::vector<std::vector<uint32_t>> children(64 + 24 + 8 + 2);
+		std::vector<float> errors(children.size(), 0.0f);
+		std::vector<uint32_t> triangles(children.size());
+
+		uint32_t begin = 0;
+		for (uint32_t lod = 0; lod + 1 < levels.size(); lod++)
+		{
+			uint32_t parents = begin + levels[lod];
+			for (uint32_t child = begin; child < begin + levels[lod]; child++)
+			{
+				// One or two parents, next to each other
+				uint32_t parent = parents + (child - begin) * levels[lod + 1] / levels[lod];
+				children[parent].push_back(child);
+				if ((rng() % 3 == 0) && (parent + 1 < parents + levels[lod + 1]))
+				{
+					children[parent + 1].push_back(child);
+				}
+			}
+			begin = parents;
+		}
+		for (uint32_t node = 0; node < children.size(); node++)
+		{
+			errors[node] = children[node].empty() ? 0.0f : float(rng() % 100);
+			triangles[node] = 1 + rng() % 50;
+		}
+
+		lod::Graph::DAG dag = makeDAG(levels, children, errors, triangles);
+
+		std::vector<lod::InstanceView> views(3, {glm::vec3(0.0f, 0.0f, 10.0f), allInside()});
+		std::vector<uint8_t> state;
+		std::vector<uint64_t> cut;
+		uint64_t budget = (round == 0) ? UINT64_MAX : 50 + rng() % 3000;
+
+		uint64_t selected = lod::selectBudgetCut(dag, {0, 2}, views, budget, 0.01f, state, cut);
+
+		std::set<uint64_t> unique(cut.begin(), cut.end());
+		assert(unique.size() == cut.size());
+		assert(selected == cutTriangles(dag, cut));
+		assert((selected <= budget) || (cut.size() == 4)); // The roots are always selected
+
+		// Only the visible instances have a state, instance 2 follows instance 0
+		assert(state.size() == 2 * dag.size());
+		for (uint64_t key : cut)
+		{
+			assert(lod::drawnInstance(key) != 1);
+			assert(state[(lod::drawnInstance(key) / 2) * dag.size() + lod::drawnNode(key)] == lod::BUDGET_IN_CUT);
+		}
+
+		// Without a budget every leaf of both instances is drawn once
+		if (budget == UINT64_MAX)
+		{
+			assert(cut.size() == 2 * 64);
+			for (uint64_t key : cut)
+			{
+				assert(lod::drawnNode(key) < 64);
+			}
+		}
+	}
+}
+
+int main()
+{
+	checkSharedChild();
+	checkMeshes();
+	checkRandomDAGs();
+
+	printf("selectBudgetCut: ok\n");
+	return 0;
+}
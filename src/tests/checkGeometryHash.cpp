@@ -0,0 +1,81 @@
+#include "checks.h"
+
+#include "jsvk/geometryProcessing.h"
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// lodGeometry.cpp defines it for the renderer
+bool SHOW_MESSAGES = false;
+
+// A grid of quads in model space, the same input the meshlet generation gets from a loaded file
+static void makeGrid(int size, std::vector<mm::Vertex> &vertices, std::vector<uint32_t> &indices)
+{
+	for (int z = 0; z < size; ++z)
+	{
+		for (int x = 0; x < size; ++x)
+		{
+			mm::Vertex vertex{};
+			vertex.pos = glm::vec3(float(x), 0.25f * float((x * z) % 3), float(z));
+			vertex.color = glm::vec3(0.0f, 1.0f, 0.0f);
+			vertices.push_back(vertex);
+		}
+	}
+
+	for (int z = 0; z + 1 < size; ++z)
+	{
+		for (int x = 0; x + 1 < size; ++x)
+		{
+			uint32_t i = z * size + x;
+			indices.insert(indices.end(), {i, i + size, i + 1, i + 1, i + size, i + size + 1});
+		}
+	}
+}
+
+static NVMeshlet::Builder<uint32_t>::MeshletGeometry buildMeshlets(const std::vector<mm::Vertex> &vertices, std::vector<uint32_t> indices)
+{
+	std::unordered_map<unsigned int, mm::Vert *> indexVertexMap;
+	std::vector<mm::Triangle *> triangles;
+	std::vector<mm::MeshletCache<uint32_t>> meshlets;
+
+	mm::makeMesh(&indexVertexMap, &triangles, indices.size(), indices.data());
+	mm::generateMeshlets(indexVertexMap, triangles, meshlets, vertices.data(), 1, mm::MESHLET_PRIMITIVE_LIMIT);
+
+	return mm::packNVMeshlets(meshlets);
+}
+
+int main()
+{
+	std::vector<mm::Vertex> vertices;
+	std::vector<uint32_t> indices;
+	makeGrid(24, vertices, indices);
+
+	NVMeshlet::Builder<uint32_t>::MeshletGeometry geometry = buildMeshlets(vertices, indices);
+	uint64_t hash = mm::hashGeometry(geometry, vertices.data(), vertices.size());
+
+	// A second load of the same model space content is found and compares equal
+	std::vector<mm::Vertex> copy = vertices;
+	NVMeshlet::Builder<uint32_t>::MeshletGeometry copyGeometry = buildMeshlets(copy, indices);
+	assert(mm::hashGeometry(copyGeometry, copy.data(), copy.size()) == hash);
+	assert(mm::isSameGeometry(geometry, vertices.data(), vertices.size(), copyGeometry, copy.data(), copy.size()));
+
+	// The placement is not part of the geometry, baked into the vertices the copy is unique
+	std::vector<mm::Vertex> placed = vertices;
+	for (auto &vertex : placed)
+	{
+		vertex.pos += glm::vec3(100.0f, 0.0f, 0.0f);
+	}
+	NVMeshlet::Builder<uint32_t>::MeshletGeometry placedGeometry = buildMeshlets(placed, indices);
+	assert(mm::hashGeometry(placedGeometry, placed.data(), placed.size()) != hash);
+	assert(!mm::isSameGeometry(geometry, vertices.data(), vertices.size(), placedGeometry, placed.data(), placed.size()));
+
+	// Same vertices with a different topology are different geometry
+	std::vector<uint32_t> flipped = indices;
+	std::swap(flipped[1], flipped[2]);
+	NVMeshlet::Builder<uint32_t>::MeshletGeometry flippedGeometry = buildMeshlets(vertices, flipped);
+	assert(!mm::isSameGeometry(geometry, vertices.data(), vertices.size(), flippedGeometry, vertices.data(), vertices.size()));
+
+	printf("hashGeometry: %zu meshlets, hash %016llx\n", geometry.meshletDescriptors.size(), (unsigned long long)hash);
+	return 0;
+}
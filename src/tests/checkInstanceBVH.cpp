@@ -0,0 +1,109 @@
+#include "checks.h"
+
+#include "jsvk/lodInstances.hpp"
+
+#include <limits>
+#include <random>
+#include <set>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// A slab in x and everything in front of z = -100, the other planes are far away
+static lod::FrustumPlanes slab()
+{
+	const float P[6][4] = {{1, 0, 0, 200}, {-1, 0, 0, 300}, {0, 0, 1, 100}, {0, 0, -1, 1e6f}, {0, 1, 0, 1e6f}, {0, -1, 0, 1e6f}};
+
+	lod::FrustumPlanes planes;
+	for (int p = 0; p < 6; p++)
+	{
+		planes.nx[p] = P[p][0];
+		planes.ny[p] = P[p][1];
+		planes.nz[p] = P[p][2];
+		planes.d[p] = P[p][3];
+	}
+	return planes;
+}
+
+static lod::BoundingBox randomBox(std::mt19937 &rng)
+{
+	std::uniform_real_distribution<float> position(-1000.0f, 1000.0f), size(1.0f, 20.0f);
+
+	glm::vec3 center(position(rng), position(rng) * 0.1f, position(rng));
+	float s = size(rng);
+
+	lod::BoundingBox bb;
+	bb.minPoint = center - glm::vec3(s);
+	bb.maxPoint = center + glm::vec3(s);
+	return bb;
+}
+
+// What the query has to return, every box tested on its own
+static std::set<uint32_t> bruteForce(const lod::BoundsSoA &bounds, const lod::FrustumPlanes &planes, const glm::vec3 &position, float maxDistance)
+{
+	std::set<uint32_t> visible;
+	for (uint32_t i = 0; i < bounds.size(); i++)
+	{
+		lod::CullResult result;
+		lod::cullBounds_scalar(planes, bounds, &i, 1, &result);
+
+		lod::BoundingBox bb = bounds[i];
+		if ((result != lod::CULL_OUTSIDE) && (glm::length(glm::clamp(position, bb.minPoint, bb.maxPoint) - position) <= maxDistance))
+		{
+			visible.insert(i);
+		}
+	}
+	return visible;
+}
+
+// Built on several threads, refitted after some instances moved and queried with and without a distance, the query
+// returns every instance once and exactly those the brute force test accepts
+static void checkQuery()
+{
+	std::mt19937 rng(3);
+	const lod::FrustumPlanes planes = slab();
+	const glm::vec3 position(0.0f);
+
+	for (uint32_t count : {0u, 1u, 3u, 4u, 5u, 17u, 1000u, 20000u})
+	{
+		lod::BoundsSoA bounds;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			bounds.push_back(randomBox(rng));
+		}
+
+		lod::InstanceBVH bvh;
+		bvh.build(bounds, 8);
+		assert(bvh.instanceCount() == count);
+
+		for (int round = 0; round < 3; round++)
+		{
+			for (float maxDistance : {600.0f, std::numeric_limits<float>::infinity()})
+			{
+				std::vector<uint32_t> visible;
+				bvh.query(bounds, planes, position, maxDistance, visible);
+
+				std::set<uint32_t> unique(visible.begin(), visible.end());
+				assert(unique.size() == visible.size());
+				assert(unique == bruteForce(bounds, planes, position, maxDistance));
+			}
+
+			std::vector<uint32_t> moved;
+			for (uint32_t m = 0; (count > 0) && (m < count / 10 + 1); m++)
+			{
+				uint32_t i = rng() % count;
+				bounds.set(i, randomBox(rng));
+				moved.push_back(i);
+			}
+			bvh.refit(bounds, moved);
+		}
+	}
+}
+
+int main()
+{
+	checkQuery();
+
+	printf("InstanceBVH: ok\n");
+	return 0;
+}
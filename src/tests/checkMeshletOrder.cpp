@@ -0,0 +1,127 @@
+#include "checks.h"
+
+#include "jsvk/geometryProcessing.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// lodGeometry.cpp defines it for the renderer
+bool SHOW_MESSAGES = false;
+
+// A bumpy grid of quads in model space
+static void makeGrid(int size, std::vector<mm::Vertex> &vertices, std::vector<uint32_t> &indices)
+{
+	for (int z = 0; z < size; ++z)
+	{
+		for (int x = 0; x < size; ++x)
+		{
+			mm::Vertex vertex{};
+			vertex.pos = glm::vec3(float(x), 0.25f * float((x * z) % 3), float(z));
+			vertices.push_back(vertex);
+		}
+	}
+
+	for (int z = 0; z + 1 < size; ++z)
+	{
+		for (int x = 0; x + 1 < size; ++x)
+		{
+			uint32_t i = z * size + x;
+			indices.insert(indices.end(), {i, i + size, i + 1, i + 1, i + size, i + size + 1});
+		}
+	}
+}
+
+// The vertices and triangles of a meshlet, two meshlets with the same signature are the same meshlet
+static std::vector<uint32_t> signature(const mm::MeshletCache<uint32_t> &meshlet)
+{
+	std::vector<uint32_t> words(meshlet.vertices, meshlet.vertices + meshlet.numVertices);
+	for (uint32_t p = 0; p < meshlet.numPrims; ++p)
+	{
+		words.insert(words.end(), {meshlet.primitives[p][0], meshlet.primitives[p][1], meshlet.primitives[p][2]});
+	}
+	return words;
+}
+
+static std::vector<std::vector<uint32_t>> signatures(const std::vector<mm::MeshletCache<uint32_t>> &meshlets)
+{
+	std::vector<std::vector<uint32_t>> words;
+	for (const auto &meshlet : meshlets)
+	{
+		words.push_back(signature(meshlet));
+	}
+	return words;
+}
+
+static glm::vec3 center(const mm::MeshletCache<uint32_t> &meshlet, const std::vector<mm::Vertex> &vertices)
+{
+	glm::vec3 sum(0.0f);
+	for (uint32_t v = 0; v < meshlet.numVertices; ++v)
+	{
+		sum += vertices[meshlet.vertices[v]].pos;
+	}
+	return sum / float(meshlet.numVertices);
+}
+
+// The distance walked from the center of every meshlet to the next one in the list
+static float pathLength(const std::vector<mm::MeshletCache<uint32_t>> &meshlets, const std::vector<mm::Vertex> &vertices)
+{
+	float length = 0.0f;
+	for (size_t m = 1; m < meshlets.size(); ++m)
+	{
+		length += glm::length(center(meshlets[m], vertices) - center(meshlets[m - 1], vertices));
+	}
+	return length;
+}
+
+int main()
+{
+	std::vector<mm::Vertex> vertices;
+	std::vector<uint32_t> indices;
+	makeGrid(64, vertices, indices);
+
+	std::unordered_map<unsigned int, mm::Vert *> indexVertexMap;
+	std::vector<mm::Triangle *> triangles;
+	std::vector<mm::MeshletCache<uint32_t>> meshlets;
+
+	mm::makeMesh(&indexVertexMap, &triangles, indices.size(), indices.data());
+	mm::generateMeshlets(indexVertexMap, triangles, meshlets, vertices.data(), 1, mm::MESHLET_PRIMITIVE_LIMIT);
+	assert(meshlets.size() > 16);
+
+	// Shuffled, the neighbours of a meshlet are anywhere in the list
+	std::shuffle(meshlets.begin(), meshlets.end(), std::mt19937(5));
+	std::vector<std::vector<uint32_t>> before = signatures(meshlets);
+	float shuffledLength = pathLength(meshlets, vertices);
+
+	mm::sortMeshletsSpatially(meshlets, vertices.data());
+
+	// Only the order changes, every meshlet is still there once
+	std::vector<std::vector<uint32_t>> after = signatures(meshlets);
+	assert(after.size() == before.size());
+	std::sort(before.begin(), before.end());
+	std::vector<std::vector<uint32_t>> sortedAfter = after;
+	std::sort(sortedAfter.begin(), sortedAfter.end());
+	assert(sortedAfter == before);
+
+	// Neighbours are next to each other in the list
+	float sortedLength = pathLength(meshlets, vertices);
+	assert(sortedLength * 2.0f < shuffledLength);
+
+	// Sorting again keeps the order
+	mm::sortMeshletsSpatially(meshlets, vertices.data());
+	assert(signatures(meshlets) == after);
+
+	// Nothing to sort
+	std::vector<mm::MeshletCache<uint32_t>> single(meshlets.begin(), meshlets.begin() + 1);
+	mm::sortMeshletsSpatially(single, vertices.data());
+	assert(signatures(single) == std::vector<std::vector<uint32_t>>{after.front()});
+
+	std::vector<mm::MeshletCache<uint32_t>> none;
+	mm::sortMeshletsSpatially(none, vertices.data());
+	assert(none.empty());
+
+	printf("sortMeshletsSpatially: %zu meshlets, path %.1f shuffled and %.1f sorted\n", meshlets.size(), shuffledLength, sortedLength);
+	return 0;
+}
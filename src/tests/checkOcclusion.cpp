@@ -0,0 +1,160 @@
+#include "checks.h"
+
+#include "jsvk/lodOcclusion.hpp"
+
+#include <cfloat>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+// The camera sits in the origin and looks down -z, w is the distance along the view direction
+static const float NEAR_PLANE = 0.1f;
+
+static glm::mat4 viewProjection()
+{
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	return glm::perspective(glm::radians(60.0f), 1.0f, NEAR_PLANE, 1000.0f) * view;
+}
+
+static lod::BoundingBox box(glm::vec3 center, glm::vec3 halfSize)
+{
+	lod::BoundingBox bb;
+	bb.minPoint = center - halfSize;
+	bb.maxPoint = center + halfSize;
+	return bb;
+}
+
+// A square facing the camera at the depth, two triangles of opposite winding so that both are rasterized
+static void addQuad(float depth, float halfSize, std::vector<glm::vec3> &positions)
+{
+	glm::vec3 p00(-halfSize, -halfSize, -depth), p10(halfSize, -halfSize, -depth);
+	glm::vec3 p01(-halfSize, halfSize, -depth), p11(halfSize, halfSize, -depth);
+	positions.insert(positions.end(), {p00, p10, p11, p00, p01, p11});
+}
+
+static void rasterize(lod::OcclusionBuffer &buffer, bool scalar)
+{
+	for (uint32_t band = 0; band < buffer.bandCount(); band++)
+	{
+		if (scalar)
+		{
+			buffer.rasterizeBand_scalar(band);
+		}
+		else
+		{
+			buffer.rasterizeBand(band);
+		}
+	}
+}
+
+// A quad 10 units away covers the middle of the screen, what is behind it is culled and everything else is kept
+static void checkQuad()
+{
+	std::vector<glm::vec3> positions;
+	addQuad(10.0f, 3.0f, positions);
+
+	lod::OcclusionBuffer buffer;
+	buffer.resize(64, 1.0f);
+	buffer.setup(viewProjection(), NEAR_PLANE, positions, std::vector<float>(2, 0.0f));
+	assert(buffer.triangleCount() == 2);
+	rasterize(buffer, false);
+
+	// The depth is the view distance of the quad
+	glm::uvec2 resolution = buffer.resolution();
+	assert(std::abs(buffer.depthAt(resolution.x / 2, resolution.y / 2) - 10.0f) < 1e-3f);
+
+	// Behind, also far behind and larger than a pixel
+	assert(!buffer.isVisible(box(glm::vec3(0.0f, 0.0f, -20.0f), glm::vec3(0.5f))));
+	assert(!buffer.isVisible(box(glm::vec3(1.0f, -1.0f, -100.0f), glm::vec3(5.0f))));
+
+	// In front, touching the quad from the front, beside it and partly covered
+	assert(buffer.isVisible(box(glm::vec3(0.0f, 0.0f, -5.0f), glm::vec3(0.5f))));
+	assert(buffer.isVisible(box(glm::vec3(0.0f, 0.0f, -9.5f), glm::vec3(0.6f))));
+	assert(buffer.isVisible(box(glm::vec3(15.0f, 0.0f, -20.0f), glm::vec3(0.5f))));
+	assert(buffer.isVisible(box(glm::vec3(6.0f, 0.0f, -20.0f), glm::vec3(1.0f))));
+
+	// Crossing the near plane, also when the rest of it is behind the quad
+	assert(buffer.isVisible(box(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.2f))));
+	assert(buffer.isVisible(box(glm::vec3(0.0f, 0.0f, -15.0f), glm::vec3(0.5f, 0.5f, 15.0f))));
+
+	// Behind the camera
+	assert(buffer.isVisible(box(glm::vec3(0.0f, 0.0f, 20.0f), glm::vec3(0.5f))));
+
+	// The margin moves the occluder back, a box just behind the quad is no longer covered
+	buffer.setup(viewProjection(), NEAR_PLANE, positions, std::vector<float>(2, 1.0f));
+	rasterize(buffer, false);
+	assert(buffer.isVisible(box(glm::vec3(0.0f, 0.0f, -10.7f), glm::vec3(0.1f))));
+	assert(!buffer.isVisible(box(glm::vec3(0.0f, 0.0f, -20.0f), glm::vec3(0.5f))));
+}
+
+// Occluders crossing the near plane are left out, they hide nothing
+static void checkNearPlane()
+{
+	std::vector<glm::vec3> positions = {glm::vec3(-50.0f, -50.0f, 1.0f), glm::vec3(50.0f, -50.0f, 1.0f), glm::vec3(0.0f, 50.0f, -5.0f)};
+
+	lod::OcclusionBuffer buffer;
+	buffer.resize(64, 1.0f);
+	buffer.setup(viewProjection(), NEAR_PLANE, positions, std::vector<float>(1, 0.0f));
+	assert(buffer.triangleCount() == 0);
+	rasterize(buffer, false);
+
+	assert(buffer.isVisible(box(glm::vec3(0.0f, 0.0f, -20.0f), glm::vec3(0.5f))));
+}
+
+// Slanted random triangles rasterized by both kernels give the same pixels with the same depth
+static void checkKernels()
+{
+	std::mt19937 rng(23);
+	std::uniform_real_distribution<float> lateral(-30.0f, 30.0f), distance(2.0f, 60.0f), margin(0.0f, 0.5f);
+
+	std::vector<glm::vec3> positions;
+	std::vector<float> margins;
+	for (int t = 0; t < 300; t++)
+	{
+		for (int v = 0; v < 3; v++)
+		{
+			positions.push_back(glm::vec3(lateral(rng), lateral(rng), -distance(rng)));
+		}
+		margins.push_back(margin(rng));
+	}
+
+	// A width that is not a multiple of four tiles and an aspect that is not square
+	lod::OcclusionBuffer kernel, reference;
+	for (lod::OcclusionBuffer *buffer : {&kernel, &reference})
+	{
+		buffer->resize(100, 1.7f);
+		buffer->setup(viewProjection(), NEAR_PLANE, positions, margins);
+	}
+	rasterize(kernel, false);
+	rasterize(reference, true);
+
+	glm::uvec2 resolution = kernel.resolution();
+	assert(resolution == reference.resolution());
+
+	uint32_t covered = 0;
+	for (uint32_t y = 0; y < resolution.y; y++)
+	{
+		for (uint32_t x = 0; x < resolution.x; x++)
+		{
+			float a = kernel.depthAt(x, y);
+			float b = reference.depthAt(x, y);
+			assert((a == FLT_MAX) == (b == FLT_MAX));
+			assert(std::abs(a - b) <= 1e-5f * b);
+			covered += (a != FLT_MAX) ? 1 : 0;
+		}
+	}
+	assert(covered > resolution.x * resolution.y / 4);
+}
+
+int main()
+{
+	checkQuad();
+	checkNearPlane();
+	checkKernels();
+
+	printf("OcclusionBuffer: ok (%s)\n", lod::OcclusionBuffer::kernel());
+	return 0;
+}
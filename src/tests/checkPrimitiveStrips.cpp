@@ -0,0 +1,216 @@
+#include "checks.h"
+
+#include "jsvk/geometryProcessing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// lodGeometry.cpp defines it for the renderer
+bool SHOW_MESSAGES = false;
+
+// A grid of quads gives long strips
+static void makeGrid(int size, std::vector<mm::Vertex> &vertices, std::vector<uint32_t> &indices)
+{
+	uint32_t first = uint32_t(vertices.size());
+	for (int z = 0; z < size; ++z)
+	{
+		for (int x = 0; x < size; ++x)
+		{
+			mm::Vertex vertex{};
+			vertex.pos = glm::vec3(float(x), 0.25f * float((x * z) % 3), float(z));
+			vertices.push_back(vertex);
+		}
+	}
+
+	for (int z = 0; z + 1 < size; ++z)
+	{
+		for (int x = 0; x + 1 < size; ++x)
+		{
+			uint32_t i = first + z * size + x;
+			indices.insert(indices.end(), {i, i + size, i + 1, i + 1, i + size, i + size + 1});
+		}
+	}
+}
+
+// Rings around a center vertex, the inner ring is a fan
+static void makeDisc(int rings, int segments, std::vector<mm::Vertex> &vertices, std::vector<uint32_t> &indices)
+{
+	uint32_t center = uint32_t(vertices.size());
+	mm::Vertex vertex{};
+	vertex.pos = glm::vec3(0.0f, 0.0f, -10.0f);
+	vertices.push_back(vertex);
+
+	for (int r = 1; r <= rings; ++r)
+	{
+		for (int s = 0; s < segments; ++s)
+		{
+			float angle = 6.2831853f * float(s) / float(segments);
+			vertex.pos = glm::vec3(float(r) * cosf(angle), float(r) * sinf(angle), -10.0f);
+			vertices.push_back(vertex);
+		}
+	}
+
+	auto ring = [&](int r, int s)
+	{ return center + 1 + uint32_t((r - 1) * segments + (s % segments)); };
+	for (int s = 0; s < segments; ++s)
+	{
+		indices.insert(indices.end(), {center, ring(1, s), ring(1, s + 1)});
+	}
+	for (int r = 1; r < rings; ++r)
+	{
+		for (int s = 0; s < segments; ++s)
+		{
+			indices.insert(indices.end(), {ring(r, s), ring(r + 1, s), ring(r, s + 1), ring(r, s + 1), ring(r + 1, s), ring(r + 1, s + 1)});
+		}
+	}
+}
+
+// Triangles that share no edge, every one of them is a restart
+static void makeSoup(int count, std::vector<mm::Vertex> &vertices, std::vector<uint32_t> &indices)
+{
+	for (int t = 0; t < count; ++t)
+	{
+		uint32_t first = uint32_t(vertices.size());
+		for (int v = 0; v < 3; ++v)
+		{
+			mm::Vertex vertex{};
+			vertex.pos = glm::vec3(float(t % 16) * 3.0f + float(v == 1), 20.0f + float(t / 16) * 3.0f + float(v == 2), 0.0f);
+			vertices.push_back(vertex);
+		}
+		indices.insert(indices.end(), {first, first + 1, first + 2});
+	}
+}
+
+// The decode of meshlet.mesh, every lane decodes one triangle and the scans run over the WARP_SIZE lanes of the subgroup
+static void shaderDecode(const uint8_t *strip, uint32_t primCount, uint8_t (*triangles)[3])
+{
+	const uint32_t maskWords = NVMeshlet::computeStripMaskWords(primCount);
+	const uint8_t *entries = strip + maskWords * 3 * sizeof(uint32_t);
+	auto mask = [&](uint32_t m, uint32_t t)
+	{
+		uint32_t word;
+		memcpy(&word, strip + (m * maskWords + t / 32) * sizeof(uint32_t), sizeof(uint32_t));
+		return ((word >> (t % 32)) & 1) != 0;
+	};
+
+	uint32_t stripNext = 0;
+	uint32_t stripOther = 0;
+	for (uint32_t i = 0; i < (NVMESHLET_PRIMITIVE_COUNT + WARP_SIZE - 1) / WARP_SIZE; ++i)
+	{
+		uint32_t last[WARP_SIZE];
+		uint32_t other[WARP_SIZE];
+
+		// subgroupInclusiveAdd and subgroupInclusiveMax
+		uint32_t sum = 0;
+		uint32_t maximum = 0;
+		for (uint32_t lane = 0; lane < WARP_SIZE; ++lane)
+		{
+			uint32_t tri = lane + i * WARP_SIZE;
+			bool valid = tri < primCount;
+			uint32_t t = std::min(tri, primCount - 1);
+
+			sum += valid ? (mask(0, t) ? 3 : 1) : 0;
+			last[lane] = stripNext + sum - 1;
+			maximum = std::max(maximum, (valid && !mask(1, t)) ? last[lane] - 1 : 0);
+			other[lane] = std::max(stripOther, maximum) - 1;
+
+			if (valid)
+			{
+				bool flip = mask(2, t);
+				uint32_t previous = last[lane] - 1;
+				triangles[tri][0] = entries[flip ? previous : other[lane]];
+				triangles[tri][1] = entries[flip ? other[lane] : previous];
+				triangles[tri][2] = entries[last[lane]];
+			}
+		}
+
+		// subgroupMax
+		stripNext = *std::max_element(last, last + WARP_SIZE) + 1;
+		stripOther = *std::max_element(other, other + WARP_SIZE) + 1;
+	}
+}
+
+// Rotates the smallest index to the front, the winding stays
+static uint32_t canonical(const uint8_t *tri)
+{
+	int r = (tri[0] < tri[1] && tri[0] < tri[2]) ? 0 : (tri[1] < tri[2] ? 1 : 2);
+	return (uint32_t(tri[r]) << 16) | (uint32_t(tri[(r + 1) % 3]) << 8) | uint32_t(tri[(r + 2) % 3]);
+}
+
+static std::vector<uint32_t> canonicalTriangles(const uint8_t (*triangles)[3], uint32_t count)
+{
+	std::vector<uint32_t> words;
+	for (uint32_t t = 0; t < count; ++t)
+	{
+		words.push_back(canonical(triangles[t]));
+	}
+	std::sort(words.begin(), words.end());
+	return words;
+}
+
+// Packs the strips of every meshlet and decodes them on the CPU and the way the mesh shader does, both have to give
+// back the fitted uint8 triangles with the same winding. Returns the size of the strips against the fitted triangles
+static float checkRoundTrip(const std::vector<mm::Vertex> &vertices, std::vector<uint32_t> indices)
+{
+	std::unordered_map<unsigned int, mm::Vert *> indexVertexMap;
+	std::vector<mm::Triangle *> triangles;
+	std::vector<mm::MeshletCache<uint32_t>> meshlets;
+
+	mm::makeMesh(&indexVertexMap, &triangles, indices.size(), indices.data());
+	mm::generateMeshlets(indexVertexMap, triangles, meshlets, vertices.data(), 1, mm::MESHLET_PRIMITIVE_LIMIT);
+
+	const NVMeshlet::Builder<uint32_t>::MeshletGeometry fitted = mm::packNVMeshlets(meshlets);
+	NVMeshlet::Builder<uint32_t>::MeshletGeometry strips = fitted;
+	assert(mm::packPrimitiveStrips(strips));
+	assert(strips.meshletDescriptors.size() == fitted.meshletDescriptors.size());
+
+	for (size_t m = 0; m < fitted.meshletDescriptors.size(); ++m)
+	{
+		const NVMeshlet::MeshletDesc &before = fitted.meshletDescriptors[m];
+		const NVMeshlet::MeshletDesc &after = strips.meshletDescriptors[m];
+		const uint32_t primCount = before.getNumPrims();
+		assert(after.getNumPrims() == primCount);
+		assert(after.getPrimBegin() % NVMeshlet::PRIMITIVE_PACKING_ALIGNMENT == 0);
+
+		const uint8_t(*expected)[3] = reinterpret_cast<const uint8_t(*)[3]>(&fitted.primitiveIndices[before.getPrimBegin()]);
+		const uint8_t *strip = &strips.primitiveIndices[after.getPrimBegin()];
+
+		uint8_t decoded[NVMeshlet::MAX_PRIMITIVE_COUNT_LIMIT][3];
+		NVMeshlet::unpackPrimitiveStrip(strip, primCount, decoded);
+		uint8_t shaded[NVMeshlet::MAX_PRIMITIVE_COUNT_LIMIT][3];
+		shaderDecode(strip, primCount, shaded);
+
+		for (uint32_t t = 0; t < primCount; ++t)
+		{
+			assert(canonical(decoded[t]) == canonical(shaded[t]));
+		}
+		assert(canonicalTriangles(decoded, primCount) == canonicalTriangles(expected, primCount));
+	}
+
+	return float(strips.primitiveIndices.size()) / float(fitted.primitiveIndices.size());
+}
+
+int main()
+{
+	std::vector<mm::Vertex> vertices;
+	std::vector<uint32_t> indices;
+	makeGrid(48, vertices, indices);
+	float grid = checkRoundTrip(vertices, indices);
+	assert(grid < 1.0f);
+
+	vertices.clear();
+	indices.clear();
+	makeDisc(12, 40, vertices, indices);
+	float disc = checkRoundTrip(vertices, indices);
+
+	vertices.clear();
+	indices.clear();
+	makeSoup(300, vertices, indices);
+	float soup = checkRoundTrip(vertices, indices);
+
+	printf("packPrimitiveStrips: %.2f, %.2f and %.2f of the fitted size for the grid, disc and soup\n", grid, disc, soup);
+	return 0;
+}
@@ -0,0 +1,115 @@
+#include "checks.h"
+
+#include "jsvk/geometryProcessing.h"
+
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// lodGeometry.cpp defines it for the renderer
+bool SHOW_MESSAGES = false;
+
+// Octahedral normals of NORMAL_BITS per component in degrees, the precise encoding stays below 0.7 with 8 bits and the
+// 16-bit bound is what acosf can resolve in float
+static const float NORMAL_ERROR_BOUND = (NVMESHLET_VERTEX_QUANTIZED_NORMAL_BITS == 16) ? 0.05f : 1.0f;
+
+// Random positions in the box and random unit normals, the normal is stored in the color
+static std::vector<mm::Vertex> randomVertices(std::mt19937 &rng, size_t count, glm::vec3 minPoint, glm::vec3 maxPoint)
+{
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::normal_distribution<float> gauss;
+
+	std::vector<mm::Vertex> vertices(count);
+	for (mm::Vertex &vertex : vertices)
+	{
+		vertex = mm::Vertex{};
+		vertex.pos = minPoint + glm::vec3(unit(rng), unit(rng), unit(rng)) * (maxPoint - minPoint);
+
+		glm::vec3 normal(gauss(rng), gauss(rng), gauss(rng));
+		vertex.color = glm::normalize(normal) * (0.5f + unit(rng)); // Not unit length, the stream normalizes it
+	}
+	return vertices;
+}
+
+// Every component of every position within half a quantization step of the bounds, the normals within the bound
+static void checkMesh(const std::vector<mm::Vertex> &vertices, const uint32_t *stream)
+{
+	glm::vec3 minPoint(FLT_MAX), maxPoint(-FLT_MAX);
+	for (const mm::Vertex &vertex : vertices)
+	{
+		minPoint = glm::min(minPoint, vertex.pos);
+		maxPoint = glm::max(maxPoint, vertex.pos);
+	}
+	glm::vec3 step = (maxPoint - minPoint) / 65535.0f;
+
+	for (size_t i = 0; i < vertices.size(); ++i)
+	{
+		glm::vec3 pos, normal;
+		mm::dequantizeVertex(stream, uint32_t(i), pos, normal);
+
+		for (int c = 0; c < 3; ++c)
+		{
+			assert(std::abs(pos[c] - vertices[i].pos[c]) <= 0.5f * step[c] * 1.001f + 1e-6f * std::max(std::abs(maxPoint[c]), std::abs(minPoint[c])));
+		}
+
+		assert(std::abs(glm::length(normal) - 1.0f) < 1e-3f);
+		float cosine = glm::clamp(glm::dot(normal, glm::normalize(vertices[i].color)), -1.0f, 1.0f);
+		assert(glm::degrees(acosf(cosine)) <= NORMAL_ERROR_BOUND);
+	}
+
+	float positionError, normalError;
+	assert(mm::checkQuantizedVertices(vertices.data(), vertices.size(), stream, positionError, normalError));
+	assert(normalError <= NORMAL_ERROR_BOUND);
+}
+
+int main()
+{
+	std::mt19937 rng(17);
+
+	// Several meshes in one stream like the vbo holds them, every mesh behind its own bounds
+	std::vector<std::vector<mm::Vertex>> meshes = {
+		randomVertices(rng, 5000, glm::vec3(-1.0f), glm::vec3(1.0f)),
+		randomVertices(rng, 3000, glm::vec3(100.0f, -50.0f, 2000.0f), glm::vec3(900.0f, 50.0f, 2001.0f)),
+		randomVertices(rng, 1000, glm::vec3(-3.0f, 7.0f, -3.0f), glm::vec3(3.0f, 7.0f, 3.0f)), // Flat, no extent in y
+		randomVertices(rng, 1, glm::vec3(4.0f), glm::vec3(4.0f)),							   // One vertex, no extent at all
+	};
+
+	// The axes and the seams of the octahedron
+	std::vector<mm::Vertex> axes;
+	for (glm::vec3 normal : {glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1),
+							 glm::vec3(1, 1, -1), glm::vec3(-1, 1, -1), glm::vec3(1, -1, -1), glm::vec3(-1, -1, -1)})
+	{
+		mm::Vertex vertex{};
+		vertex.pos = normal;
+		vertex.color = normal;
+		axes.push_back(vertex);
+	}
+	meshes.push_back(axes);
+
+	std::vector<uint32_t> stream;
+	std::vector<size_t> offsets;
+	for (const auto &mesh : meshes)
+	{
+		offsets.push_back(stream.size());
+		mm::quantizeVertices(mesh.data(), mesh.size(), stream);
+		assert(stream.size() - offsets.back() == NVMESHLET_VERTEX_QUANTIZED_HEADER + mesh.size() * NVMESHLET_VERTEX_QUANTIZED_STRIDE);
+	}
+
+	for (size_t m = 0; m < meshes.size(); ++m)
+	{
+		checkMesh(meshes[m], &stream[offsets[m]]);
+	}
+
+	// A vertex without a normal gets +z instead of a NaN
+	mm::Vertex flat{};
+	std::vector<uint32_t> single;
+	mm::quantizeVertices(&flat, 1, single);
+	glm::vec3 pos, normal;
+	mm::dequantizeVertex(single.data(), 0, pos, normal);
+	assert(pos == glm::vec3(0.0f));
+	assert(glm::length(normal - glm::vec3(0.0f, 0.0f, 1.0f)) < 1e-3f);
+
+	printf("quantizeVertices: %zu meshes, %zu words\n", meshes.size(), stream.size());
+	return 0;
+}
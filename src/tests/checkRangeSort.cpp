@@ -0,0 +1,74 @@
+#include "checks.h"
+
+#include "jsvk/lodSelection.hpp"
+#include "jsvk/lodThreadStealers.hpp"
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+// The radix sort is stable, so it has to give what std::stable_sort gives for the keys and their nodes, on one block
+// and on several blocks spread over the pool
+static void checkAgainstStableSort(lod::ThreadPool &pool)
+{
+	std::mt19937 rng(11);
+	lod::RangeSortScratch scratch;
+
+	for (size_t count : {size_t(0), size_t(1), size_t(2), size_t(100), lod::RADIX_BLOCK - 1, 3 * lod::RADIX_BLOCK + 17, 20 * lod::RADIX_BLOCK})
+	{
+		for (uint32_t instances : {1u, 7u, 5000u})
+		{
+			std::vector<uint64_t> keys;
+			std::vector<uint32_t> nodes;
+			for (size_t i = 0; i < count; i++)
+			{
+				// Few LoDs and meshlets so that equal keys are common and the stability shows
+				keys.push_back(lod::rangeKey(rng() % instances, rng() % 4, rng() % 300));
+				nodes.push_back(uint32_t(i));
+			}
+
+			std::vector<std::pair<uint64_t, uint32_t>> expected;
+			for (size_t i = 0; i < count; i++)
+			{
+				expected.push_back({keys[i], nodes[i]});
+			}
+			std::stable_sort(expected.begin(), expected.end(), [](const auto &a, const auto &b)
+							 { return a.first < b.first; });
+
+			lod::sortRanges(keys, nodes, scratch, pool);
+
+			assert(keys.size() == count);
+			assert(nodes.size() == count);
+			for (size_t i = 0; i < count; i++)
+			{
+				assert(keys[i] == expected[i].first);
+				assert(nodes[i] == expected[i].second);
+			}
+		}
+	}
+}
+
+// The packed fields come back out of a key
+static void checkRangeKey()
+{
+	uint64_t key = lod::rangeKey(0xABCDEF, 0x12, 0xFEDCBA98);
+	assert(lod::rangeInstance(key) == 0xABCDEF);
+	assert(lod::rangeLOD(key) == 0x12);
+	assert(lod::rangeMeshlet(key) == 0xFEDCBA98);
+
+	// The instance decides the order before the LoD and the LoD before the meshlet
+	assert(lod::rangeKey(1, 0, 0) > lod::rangeKey(0, 255, 0xFFFFFFFF));
+	assert(lod::rangeKey(0, 1, 0) > lod::rangeKey(0, 0, 0xFFFFFFFF));
+}
+
+int main()
+{
+	lod::ThreadPool pool(4);
+
+	checkRangeKey();
+	checkAgainstStableSort(pool);
+
+	printf("sortRanges: ok\n");
+	return 0;
+}
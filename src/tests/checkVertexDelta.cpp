@@ -0,0 +1,131 @@
+#include "checks.h"
+
+#include "jsvk/geometryProcessing.h"
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// lodGeometry.cpp defines it for the renderer
+bool SHOW_MESSAGES = false;
+
+// A grid of quads, wide grids give meshlets whose vertex indices span more than 8 bits
+static void makeGrid(int width, int depth, std::vector<mm::Vertex> &vertices, std::vector<uint32_t> &indices)
+{
+	for (int z = 0; z < depth; ++z)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			mm::Vertex vertex{};
+			vertex.pos = glm::vec3(float(x), 0.0f, float(z));
+			vertices.push_back(vertex);
+		}
+	}
+
+	for (int z = 0; z + 1 < depth; ++z)
+	{
+		for (int x = 0; x + 1 < width; ++x)
+		{
+			uint32_t i = z * width + x;
+			indices.insert(indices.end(), {i, i + width, i + 1, i + 1, i + width, i + width + 1});
+		}
+	}
+}
+
+static NVMeshlet::Builder<uint32_t>::MeshletGeometry buildMeshlets(const std::vector<mm::Vertex> &vertices, std::vector<uint32_t> indices)
+{
+	std::unordered_map<unsigned int, mm::Vert *> indexVertexMap;
+	std::vector<mm::Triangle *> triangles;
+	std::vector<mm::MeshletCache<uint32_t>> meshlets;
+
+	mm::makeMesh(&indexVertexMap, &triangles, indices.size(), indices.data());
+	mm::generateMeshlets(indexVertexMap, triangles, meshlets, vertices.data(), 1, mm::MESHLET_PRIMITIVE_LIMIT);
+
+	return mm::packNVMeshlets(meshlets);
+}
+
+static uint32_t bitfieldExtract(uint32_t value, int offset, int bits)
+{
+	return (value >> offset) & ((bits == 32) ? ~0u : ((1u << bits) - 1u));
+}
+
+// getVertexIndex of meshlet.mesh, the run of the meshlet starts at vertBegin of the model at geometryOffset in the ibo
+static uint32_t shaderVertexIndex(const std::vector<uint32_t> &ibo, uint32_t vertBegin, uint32_t geometryOffset, uint32_t v)
+{
+	uint32_t begin = vertBegin + geometryOffset;
+	uint32_t header = ibo[begin];
+	uint32_t base = header & ((1u << NVMESHLET_VERTEX_DELTA_BASE_BITS) - 1u);
+	uint32_t width = header >> NVMESHLET_VERTEX_DELTA_BASE_BITS;
+	uint32_t deltas = begin + 1;
+
+	if (width == 0)
+		return base + bitfieldExtract(ibo[deltas + v / 4], int(v % 4) * 8, 8);
+	if (width == 1)
+		return base + bitfieldExtract(ibo[deltas + v / 2], int(v % 2) * 16, 16);
+	return base + ibo[deltas + v];
+}
+
+// Packs the geometry and decodes every vertex index of every meshlet on the CPU and the way the mesh shader does, both
+// have to give back the plain indices. Returns how many meshlets used each delta width
+static std::vector<uint32_t> checkRoundTrip(const NVMeshlet::Builder<uint32_t>::MeshletGeometry &plain)
+{
+	NVMeshlet::Builder<uint32_t>::MeshletGeometry packed = plain;
+	assert(mm::packVertexIndicesDelta(packed));
+	assert(packed.meshletDescriptors.size() == plain.meshletDescriptors.size());
+
+	// The models are concatenated in the ibo, this one behind another of 12 words
+	const uint32_t geometryOffset = 12;
+	std::vector<uint32_t> ibo(geometryOffset, 0xFFFFFFFF);
+	ibo.insert(ibo.end(), packed.vertexIndices.begin(), packed.vertexIndices.end());
+
+	std::vector<uint32_t> widths(3, 0);
+	for (size_t m = 0; m < plain.meshletDescriptors.size(); ++m)
+	{
+		const NVMeshlet::MeshletDesc &before = plain.meshletDescriptors[m];
+		const NVMeshlet::MeshletDesc &after = packed.meshletDescriptors[m];
+		assert(after.getNumVertices() == before.getNumVertices());
+
+		uint32_t vertBegin = after.getVertexBeginDelta();
+		assert(vertBegin % NVMESHLET_VERTEX_DELTA_ALIGNMENT == 0);
+		widths[packed.vertexIndices[vertBegin] >> NVMeshlet::VERTEX_DELTA_BASE_BITS]++;
+
+		for (uint32_t v = 0; v < before.getNumVertices(); ++v)
+		{
+			uint32_t expected = plain.vertexIndices[before.getVertexBegin() + v];
+			assert(NVMeshlet::unpackVertexIndexDelta(packed.vertexIndices.data(), vertBegin, v) == expected);
+			assert(shaderVertexIndex(ibo, vertBegin, geometryOffset, v) == expected);
+		}
+	}
+
+	return widths;
+}
+
+int main()
+{
+	// Meshlets of a narrow grid span few rows, all of them fit 8-bit deltas
+	std::vector<mm::Vertex> vertices;
+	std::vector<uint32_t> indices;
+	makeGrid(24, 24, vertices, indices);
+	std::vector<uint32_t> narrow = checkRoundTrip(buildMeshlets(vertices, indices));
+	assert(narrow[NVMeshlet::VERTEX_DELTA_UINT8] > 0);
+
+	// A row of a wide grid is more than 255 vertices, the meshlets need 16-bit deltas
+	vertices.clear();
+	indices.clear();
+	makeGrid(600, 6, vertices, indices);
+	std::vector<uint32_t> wide = checkRoundTrip(buildMeshlets(vertices, indices));
+	assert(wide[NVMeshlet::VERTEX_DELTA_UINT16] > 0);
+
+	// Meshlets that reference far apart vertices need the full 32 bits, only the indices are packed so they can be moved
+	NVMeshlet::Builder<uint32_t>::MeshletGeometry spread = buildMeshlets(vertices, indices);
+	for (size_t i = 0; i < spread.vertexIndices.size(); i += 2)
+	{
+		spread.vertexIndices[i] += 100000;
+	}
+	std::vector<uint32_t> far = checkRoundTrip(spread);
+	assert(far[NVMeshlet::VERTEX_DELTA_UINT32] > 0);
+
+	printf("packVertexIndicesDelta: %u, %u and %u meshlets with 8, 16 and 32-bit deltas\n", narrow[0] + wide[0] + far[0], narrow[1] + wide[1] + far[1],
+		   narrow[2] + wide[2] + far[2]);
+	return 0;
+}
@@ -0,0 +1,10 @@
+#pragma once
+#ifndef HEADER_GUARD_CHECKS
+#define HEADER_GUARD_CHECKS
+
+// The checks assert in every configuration, also in release builds
+#undef NDEBUG
+#include <cassert>
+#include <cstdio>
+
+#endif